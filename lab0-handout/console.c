@@ -12,6 +12,8 @@
 #include <sys/select.h>
 #include <fcntl.h>
 #include <ctype.h>
+#include <signal.h>
+#include <pthread.h>
 
 #include "report.h"
 #include "console.h"
@@ -19,6 +21,8 @@
 
 /* Some global values */
 static cmd_ptr cmd_list = NULL;
+/* Is the command being executed on behalf of a network client? */
+static bool remote_flag = false;
 static param_ptr param_list = NULL;
 static bool block_flag = false;
 static bool prompt_flag = true;
@@ -30,6 +34,26 @@ static bool block_timing = false;
 static double first_time;
 static double last_time;
 
+/*
+  Asynchronous execution of commands.
+  At most one job runs at a time, on a worker thread, while the console
+  is blocked.  Worker signals completion by writing to a pipe that
+  cmd_select adds to its read set.
+*/
+static int async_mode = 0;
+
+typedef struct {
+    pthread_t thread;
+    cmd_ptr cmd;
+    int argc;
+    char **argv;
+    bool ok;
+} job_t;
+
+static job_t job;
+static bool job_pending = false;
+static int job_pipe[2] = {-1, -1};
+
 /*
   Implement buffered I/O using variant of RIO package from CS:APP
   Must create stack of buffers to handle I/O with nested source commands.
@@ -82,6 +106,8 @@ static bool push_file(char *fname);
 static void pop_file();
 
 static bool interpret_cmda(int argc, char *argv[]);
+static bool start_job(cmd_ptr cmd, int argc, char *argv[]);
+static void finish_job();
 
 /* Initialize interpreter */
 void init_cmd() {
@@ -100,6 +126,8 @@ void init_cmd() {
     add_param("verbose", &verblevel, "Verbosity level", NULL);
     add_param("error", &err_limit,   "Number of errors until exit", NULL);
     add_param("echo", &echo, "Do/don't echo commands", NULL);
+    add_param("async", &async_mode,
+              "Run long commands on worker thread", NULL);
 #if 0
     add_param("megabytes", &mblimit, "Maximum megabytes allowed", NULL);
     add_param("seconds", &timelimit, "Maximum seconds allowed",
@@ -110,8 +138,9 @@ void init_cmd() {
     first_time = last_time;
 }
 
-/* Add a new command */
-void add_cmd(char *name, cmd_function operation, char *documentation) {
+/* Insert command into list, maintaining alphabetical order */
+static void insert_cmd(char *name, cmd_function operation,
+                       char *documentation, bool async) {
     cmd_ptr next_cmd = cmd_list;
     cmd_ptr *last_loc = &cmd_list;
     while (next_cmd && strcmp(name, next_cmd->name) > 0) {
@@ -122,10 +151,21 @@ void add_cmd(char *name, cmd_function operation, char *documentation) {
     ele->name = name;
     ele->operation = operation;
     ele->documentation = documentation;
+    ele->async = async;
     ele->next = next_cmd;
     *last_loc = ele;
 }
 
+/* Add a new command */
+void add_cmd(char *name, cmd_function operation, char *documentation) {
+    insert_cmd(name, operation, documentation, false);
+}
+
+/* Add a new command that can run on the worker thread */
+void add_async_cmd(char *name, cmd_function operation, char *documentation) {
+    insert_cmd(name, operation, documentation, true);
+}
+
 /* Add a new parameter */
 void add_param(char *name, int *valp, char *documentation,
                setter_function setter) {
@@ -175,6 +215,8 @@ char **parse_args(char *line, int *argcp) {
             *dst++ = c;
         }
     }
+    /* Line need not end with white space */
+    *dst = '\0';
     /* Now assemble into array of strings */
     char **argv = calloc_or_fail(argc, sizeof(char *), "parse_args");
     size_t i;
@@ -189,6 +231,9 @@ char **parse_args(char *line, int *argcp) {
 }
 
 void record_error() {
+    /* Network clients cannot exhaust the console's error limit */
+    if (remote_flag)
+        return;
     err_cnt++;
     if (err_cnt >= err_limit) {
         report(1, "Error limit exceeded.  Stopping command execution");
@@ -206,6 +251,8 @@ static bool interpret_cmda(int argc, char *argv[]) {
     while (next_cmd && strcmp(argv[0], next_cmd->name) != 0)
         next_cmd = next_cmd->next;
     if (next_cmd) {
+        if (async_mode && next_cmd->async && !remote_flag)
+            return start_job(next_cmd, argc, argv);
         ok = next_cmd->operation(argc, argv);
         if (!ok)
             record_error();
@@ -234,6 +281,17 @@ bool interpret_cmd(char *cmdline) {
     return ok;
 }
 
+/*
+  Execute a command on behalf of a network client.
+  Such commands always run synchronously and do not count toward the error limit.
+*/
+bool interpret_remote_cmd(char *cmdline) {
+    remote_flag = true;
+    bool ok = interpret_cmd(cmdline);
+    remote_flag = false;
+    return ok;
+}
+
 /* Set function to be executed as part of program exit */
 void add_quit_helper(cmd_function qf) {
     if (quit_helper_cnt < MAXQUIT) {
@@ -508,6 +566,82 @@ void unblock_console() {
 }
 
 
+/* Body of worker thread: execute command and signal completion */
+static void *run_job(void *arg) {
+    /* Main thread blocks timer signals.  This thread must receive them */
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGALRM);
+    pthread_sigmask(SIG_UNBLOCK, &mask, NULL);
+    job.ok = job.cmd->operation(job.argc, job.argv);
+    char c = 'd';
+    if (write(job_pipe[1], &c, 1) != 1)
+        report_event(MSG_FATAL, "Could not signal completion of '%s'",
+                     job.cmd->name);
+    return NULL;
+}
+
+/*
+  Launch command on worker thread and block console until it completes.
+  Arguments are copied, since caller frees its own.
+  Command status is recorded when job finishes.
+*/
+static bool start_job(cmd_ptr cmd, int argc, char *argv[]) {
+    int i;
+    if (job_pipe[0] < 0 && pipe(job_pipe) < 0) {
+        report(1, "Could not create pipe for asynchronous execution");
+        return false;
+    }
+    if (job_pipe[1] > fd_max)
+        fd_max = job_pipe[1];
+    job.cmd = cmd;
+    job.argc = argc;
+    job.argv = calloc_or_fail(argc, sizeof(char *), "start_job");
+    for (i = 0; i < argc; i++)
+        job.argv[i] = strsave_or_fail(argv[i], "start_job");
+    job.ok = false;
+    /* Keep timer signals away from main thread.  Worker inherits mask */
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    block_console();
+    job_pending = true;
+    if (pthread_create(&job.thread, NULL, run_job, NULL) != 0) {
+        report(1, "Could not start worker thread for '%s'", cmd->name);
+        job_pending = false;
+        pthread_sigmask(SIG_UNBLOCK, &mask, NULL);
+        for (i = 0; i < argc; i++)
+            free_string(job.argv[i]);
+        free_array(job.argv, argc, sizeof(char *));
+        unblock_console();
+        return false;
+    }
+    return true;
+}
+
+/* Reap completed job, record its status, and unblock console */
+static void finish_job() {
+    char c;
+    int i;
+    if (read(job_pipe[0], &c, 1) != 1)
+        report_event(MSG_FATAL, "Could not read completion of '%s'",
+                     job.cmd->name);
+    pthread_join(job.thread, NULL);
+    job_pending = false;
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGALRM);
+    pthread_sigmask(SIG_UNBLOCK, &mask, NULL);
+    for (i = 0; i < job.argc; i++)
+        free_string(job.argv[i]);
+    free_array(job.argv, job.argc, sizeof(char *));
+    if (!job.ok)
+        record_error();
+    unblock_console();
+}
+
+
 /* Determine if there is a complete command line in input buffer */
 static bool read_ready() {
     int i;
@@ -538,19 +672,30 @@ int cmd_select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
         interpret_cmd(cmdline);
         prompt_flag = true;
     }
-    if (cmd_done())
+    /* Once command input is exhausted, keep serving any network activity.
+       A job started by the last line must still be waited for */
+    if (!job_pending && (quit_flag || (buf_stack == NULL && nfds == 0)))
         return 0;
-    if (!block_flag) {
+    if (readfds == NULL) {
+        readfds = &local_readset;
+        FD_ZERO(readfds);
+    }
+    if (job_pending) {
+        /* Wait for worker thread to complete */
+        FD_SET(job_pipe[0], readfds);
+        if (job_pipe[0] >= nfds)
+            nfds = job_pipe[0]+1;
+    }
+    if (!block_flag && buf_stack) {
         /* Process any commands in input buffer */
-        if (readfds == NULL)
-            readfds = &local_readset;
         /* Add input fd to readset for select */
         infd = buf_stack->fd;
         FD_SET(infd, readfds);
         if (infd == STDIN_FILENO && prompt_flag) {
             printf("%s", prompt);
             fflush(stdout);
-            prompt_flag = true;
+            /* Network activity must not trigger another prompt */
+            prompt_flag = false;
         }
         if (infd >= nfds) {
             nfds = infd+1;
@@ -561,14 +706,21 @@ int cmd_select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
     int result = select(nfds, readfds, writefds, exceptfds, timeout);
     if (result <= 0)
         return result;
-    infd = buf_stack->fd;
-    if (readfds && FD_ISSET(infd, readfds)) {
+    if (job_pending && FD_ISSET(job_pipe[0], readfds)) {
+        /* Worker thread finished */
+        FD_CLR(job_pipe[0], readfds);
+        result--;
+        finish_job();
+    }
+    if (!block_flag && buf_stack && FD_ISSET(buf_stack->fd, readfds)) {
         /* Commandline input available */
+        infd = buf_stack->fd;
         FD_CLR(infd, readfds);
         result--;
         cmdline = readline();
         if (cmdline)
             interpret_cmd(cmdline);
+        prompt_flag = true;
     }
     return result;
 }
@@ -583,12 +735,23 @@ bool start_cmd(char *infile_name) {
 }
 
 bool cmd_done() {
-    return buf_stack == NULL || quit_flag;
+    return (buf_stack == NULL || quit_flag) && !job_pending;
+}
+
+bool cmd_quit() {
+    return quit_flag;
+}
+
+bool cmd_busy() {
+    return job_pending;
 }
 
 
 bool finish_cmd() {
     bool ok = true;
+    /* Queue must not be freed while worker is using it */
+    while (job_pending)
+        cmd_select(0, NULL, NULL, NULL, NULL);
     if (!quit_flag) {
         ok = ok && do_quit_cmd(0, NULL);
     }
@@ -10,6 +10,8 @@ struct CELE {
     char *name;
     cmd_function operation;
     char *documentation;
+    /* Can command run on worker thread when async mode enabled? */
+    bool async;
     cmd_ptr next;
 };
 
@@ -33,6 +35,13 @@ void init_cmd();
 /* Add a new command */
 void add_cmd(char *name, cmd_function operation, char *documentation);
 
+/*
+  Add a new command that is potentially long-running.
+  When the async option is set, it executes on a worker thread while the
+  console is blocked.  Completion is detected by cmd_select.
+*/
+void add_async_cmd(char *name, cmd_function operation, char *documentation);
+
 /* Add a new parameter */
 void add_param(char *name, int *valp, char *doccumentation,
                setter_function setter);
@@ -40,6 +49,12 @@ void add_param(char *name, int *valp, char *doccumentation,
 /* Execute a command from a command line */
 bool interpret_cmd(char *cmdline);
 
+/*
+  Execute a command on behalf of a network client.
+  Such commands always run synchronously and do not count toward the error limit.
+*/
+bool interpret_remote_cmd(char *cmdline);
+
 /* Execute a sequence of commands read from a file */
 bool interpret_file(FILE *fp);
     
@@ -76,6 +91,12 @@ bool start_cmd(char *infile_name);
 /* Is it time to quit the command loop? */
 bool cmd_done();
 
+/* Has a quit command been executed (or the error limit exceeded)? */
+bool cmd_quit();
+
+/* Is a command running on the worker thread? */
+bool cmd_busy();
+
 /* Complete command interpretation */
 /* Return true if no errors occurred */
 bool finish_cmd();
@@ -88,7 +109,8 @@ bool finish_cmd();
    as select.  Command input file removed from readfds
 
    nfds should be set to the maximum file descriptor for network sockets.
-   If nfds == 0, this indicates that there is no pending network activity
+   If nfds == 0, this indicates that there is no pending network activity.
+   Network activity continues to be handled once command input is exhausted.
 */
 
 int cmd_select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
@@ -6,6 +6,7 @@
 #include <setjmp.h>
 #include <signal.h>
 #include <unistd.h>
+#include <sys/time.h>
 
 #include "report.h"
 
@@ -50,7 +51,8 @@ static bool noallocate_mode = false;
 static bool error_occurred = false;
 static char *error_message = "";
 
-static int time_limit = 1;
+/* Time limit for each risky operation, in milliseconds (0 = unlimited) */
+int time_limit = 1000;
 
 /*
  * Data for managing exceptions
@@ -59,10 +61,40 @@ static jmp_buf env;
 static volatile sig_atomic_t jmp_ready = false;
 static bool time_limited = false;
 
+/*
+  A longjmp out of the library's malloc or free would leave its locks
+  held, and the next allocation would crash or hang.  A time limit that
+  expires there is raised once they return.
+*/
+static volatile sig_atomic_t in_library_alloc = false;
+static char * volatile deferred_message = NULL;
+
 
 /*
   Internal functions
  */
+/*
+  Arm (ms > 0) or disarm (ms == 0) the real-time interval timer.
+  Unlike alarm, this gives millisecond resolution.
+ */
+static void set_timer(int ms) {
+    struct itimerval it;
+    it.it_interval.tv_sec = 0;
+    it.it_interval.tv_usec = 0;
+    it.it_value.tv_sec = ms / 1000;
+    it.it_value.tv_usec = (ms % 1000) * 1000;
+    setitimer(ITIMER_REAL, &it, NULL);
+}
+
+/* Raise time limit exception deferred by trigger_time_exception */
+static void raise_deferred() {
+    char *msg = deferred_message;
+    if (msg) {
+        deferred_message = NULL;
+        trigger_exception(msg);
+    }
+}
+
 /* Should this allocation fail? */
 static bool fail_allocation() {
     double weight = (double) random() / RAND_MAX;
@@ -115,11 +147,20 @@ void *test_malloc(size_t size)
         report_event(MSG_FATAL, "Calls to malloc disallowed");
         return NULL;
     }
-    if (fail_allocation()) {
+    /* random also takes a lock */
+    in_library_alloc = true;
+    bool fail = fail_allocation();
+    block_ele_t *new_block =
+        fail ? NULL : malloc(size + sizeof(block_ele_t) + sizeof(size_t));
+    in_library_alloc = false;
+    if (deferred_message) {
+        free(new_block);
+        raise_deferred();
+    }
+    if (fail) {
         report_event(MSG_WARN, "Malloc returning NULL");
         return NULL;
     }
-    block_ele_t *new_block = malloc(size + sizeof(block_ele_t) + sizeof(size_t));
     if (new_block == NULL) {
         report_event(MSG_FATAL, "Couldn't allocate any more memory");
         error_occurred = true;
@@ -170,14 +211,26 @@ void test_free(void *p)
     if (bn)
         bn->prev = bp;
 
+    in_library_alloc = true;
     free(b);
+    in_library_alloc = false;
     allocated_count --;
+    raise_deferred();
 }
 
 size_t allocation_check() {
     return allocated_count;
 }
 
+void swap_allocation_state(alloc_state_t *sp) {
+    block_ele_t *a = allocated;
+    size_t c = allocated_count;
+    allocated = (block_ele_t *) sp->allocated;
+    allocated_count = sp->allocated_count;
+    sp->allocated = (void *) a;
+    sp->allocated_count = c;
+}
+
 /*
   Implementation of functions for testing
  */
@@ -220,7 +273,7 @@ bool exception_setup(bool limit_time) {
         /* Got here from longjmp */
         jmp_ready = false;
         if (time_limited) {
-            alarm(0);
+            set_timer(0);
             time_limited = false;
         }
         if (error_message) {
@@ -230,9 +283,10 @@ bool exception_setup(bool limit_time) {
         return false;
     } else {
         /* Got here from initial call */
+        deferred_message = NULL;
         jmp_ready = true;
-        if (limit_time) {
-            alarm(time_limit);
+        if (limit_time && time_limit > 0) {
+            set_timer(time_limit);
             time_limited = true;
         }
         return true;
@@ -244,10 +298,11 @@ bool exception_setup(bool limit_time) {
  */
 void exception_cancel() {
     if (time_limited) {
-        alarm(0);
+        set_timer(0);
         time_limited = false;
     }
     jmp_ready = false;
+    deferred_message = NULL;
     error_message = "";
 }
 
@@ -263,3 +318,14 @@ void trigger_exception(char *msg) {
     else
         exit(1);
 }
+
+/*
+ * Like trigger_exception, for a signal telling that the time limit has
+ * expired.  Inside malloc or free, wait until they return
+ */
+void trigger_time_exception(char *msg) {
+    if (in_library_alloc)
+        deferred_message = msg;
+    else
+        trigger_exception(msg);
+}
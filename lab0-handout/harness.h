@@ -15,9 +15,24 @@ void test_free(void *p);
 /* Report number of allocated blocks */
 size_t allocation_check();
 
+/*
+  Allocation bookkeeping.  Saving and restoring it lets several queues
+  be tested independently of each other.
+*/
+typedef struct {
+    void *allocated;
+    size_t allocated_count;
+} alloc_state_t;
+
+/* Exchange current allocation bookkeeping with *sp */
+void swap_allocation_state(alloc_state_t *sp);
+
 /* Probability of malloc failing, expressed as percent */
 int fail_probability;
 
+/* Time limit for each risky operation, in milliseconds (0 = unlimited) */
+extern int time_limit;
+
 /*
   Set/unset cautious mode.
   In this mode, makes extra sure any block to be freed is currently allocated.
@@ -52,6 +67,13 @@ void exception_cancel();
  */
 void trigger_exception(char *msg);
 
+/*
+ * Like trigger_exception, but for the time limit: if the signal arrived
+ * inside the library's malloc or free, the exception is raised once
+ * they return
+ */
+void trigger_time_exception(char *msg);
+
 
 #else
 /* Tested program use our versions of malloc and free */
@@ -0,0 +1,355 @@
+/* Load generator for qtest running in server mode (qtest --listen SOCK) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define BUFSIZE 8192
+
+/* Maximum number of pipeline depths to compare */
+#define MAXDEPTHS 16
+
+/* State of each client connection */
+typedef struct {
+    int fd;
+    int sent;              /* Requests sent */
+    int done;              /* Responses received */
+    double *start;         /* Send times of outstanding requests (ring) */
+    int cnt;               /* Bytes of partial response in buf */
+    char buf[BUFSIZE];
+} client_t;
+
+/* Settable parameters */
+static char *sock_name = NULL;
+static int nconns = 1;
+static int nreqs = 10000;
+static char *command = "it dolphin";
+static int vlevel = 1;
+/* Requests kept in flight on each connection */
+static int depths[MAXDEPTHS] = {1};
+static int ndepths = 1;
+
+/* Latency of every request, in seconds */
+static double *latencies;
+static int nlatencies = 0;
+static int nerrors = 0;
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1.0E-9 * ts.tv_nsec;
+}
+
+static void usage(char *cmd) {
+    printf("Usage: %s [-h] -s SOCK [-c CONNS][-n REQS][-m CMD][-p DEPTHS][-v VLEVEL]\n", cmd);
+    printf("\t-h         Print this information\n");
+    printf("\t-s SOCK    Connect to qtest server at socket SOCK\n");
+    printf("\t-c CONNS   Number of concurrent connections (default %d)\n", nconns);
+    printf("\t-n REQS    Requests per connection (default %d)\n", nreqs);
+    printf("\t-m CMD     Command to send (default '%s')\n", command);
+    printf("\t-p DEPTHS  Pipeline depth, or comma-separated list of depths to compare\n");
+    printf("\t-v VLEVEL  Server verbosity level during run (default %d)\n", vlevel);
+    exit(0);
+}
+
+static int connect_server() {
+    struct sockaddr_un addr;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        exit(1);
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sock_name, sizeof(addr.sun_path)-1);
+    if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    return fd;
+}
+
+static void write_all(int fd, char *buf, size_t len) {
+    size_t sent = 0;
+    while (sent < len) {
+        ssize_t n = write(fd, buf + sent, len - sent);
+        if (n <= 0) {
+            perror("write");
+            exit(1);
+        }
+        sent += n;
+    }
+}
+
+static void send_line(client_t *c, char *line) {
+    char buf[BUFSIZE];
+    int len = snprintf(buf, BUFSIZE, "%s\n", line);
+    write_all(c->fd, buf, len);
+}
+
+/* Send cnt copies of command with a single write, recording send times */
+static void send_batch(client_t *c, int cnt, int depth) {
+    static char *buf = NULL;
+    static size_t buflen = 0;
+    size_t len = strlen(command) + 1;
+    int i;
+    if (buflen < cnt * len) {
+        buflen = cnt * len;
+        buf = realloc(buf, buflen);
+        if (buf == NULL) {
+            printf("Could not allocate space for batch of %d requests\n", cnt);
+            exit(1);
+        }
+    }
+    for (i = 0; i < cnt; i++) {
+        memcpy(buf + i * len, command, len - 1);
+        buf[i * len + len - 1] = '\n';
+    }
+    double t = now();
+    for (i = 0; i < cnt; i++)
+        c->start[(c->sent + i) % depth] = t;
+    write_all(c->fd, buf, cnt * len);
+    c->sent += cnt;
+}
+
+/*
+  Consume available response text.
+  Return number of responses completed, -1 if server closed connection
+*/
+static int read_responses(client_t *c, bool *errp) {
+    int n = read(c->fd, c->buf + c->cnt, BUFSIZE - 1 - c->cnt);
+    int responses = 0;
+    if (n <= 0)
+        return -1;
+    c->cnt += n;
+    char *start = c->buf;
+    char *end = c->buf + c->cnt;
+    char *nl;
+    while ((nl = memchr(start, '\n', end - start)) != NULL) {
+        size_t len = nl - start;
+        if (len == 3 && strncmp(start, "+OK", 3) == 0)
+            responses++;
+        else if (len == 4 && strncmp(start, "-ERR", 4) == 0) {
+            responses++;
+            *errp = true;
+        }
+        start = nl + 1;
+    }
+    c->cnt = end - start;
+    if (c->cnt == BUFSIZE - 1)
+        /* Very long output line.  Only the status lines matter */
+        c->cnt = 0;
+    memmove(c->buf, start, c->cnt);
+    return responses;
+}
+
+/* Send request and wait for its response */
+static bool round_trip(client_t *c, char *line) {
+    bool err = false;
+    int r = 0;
+    send_line(c, line);
+    while (r == 0)
+        r = read_responses(c, &err);
+    return r > 0 && !err;
+}
+
+/*
+  Get the server's verbosity level from its option listing.
+  The listing is only printed at level 1 and above, so a missing entry means 0.
+*/
+static int get_verbose(client_t *c) {
+    int level = 0;
+    bool done = false;
+    send_line(c, "option");
+    while (!done) {
+        int n = read(c->fd, c->buf + c->cnt, BUFSIZE - 1 - c->cnt);
+        if (n <= 0) {
+            printf("Server closed connection\n");
+            exit(1);
+        }
+        c->cnt += n;
+        char *start = c->buf;
+        char *end = c->buf + c->cnt;
+        char *nl;
+        while (!done && (nl = memchr(start, '\n', end - start)) != NULL) {
+            *nl = '\0';
+            sscanf(start, "\tverbose\t%d", &level);
+            done = strcmp(start, "+OK") == 0 || strcmp(start, "-ERR") == 0;
+            start = nl + 1;
+        }
+        c->cnt = end - start;
+        if (c->cnt == BUFSIZE - 1)
+            c->cnt = 0;
+        memmove(c->buf, start, c->cnt);
+    }
+    return level;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double da = *(const double *) a;
+    double db = *(const double *) b;
+    return da < db ? -1 : da > db ? 1 : 0;
+}
+
+/* Run closed-loop test with depth requests kept in flight on each connection */
+static void run_depth(client_t *clients, struct pollfd *pfds, int depth) {
+    int i, j;
+    nlatencies = 0;
+    nerrors = 0;
+    /* Start each connection with a fresh queue */
+    for (i = 0; i < nconns; i++) {
+        clients[i].sent = 0;
+        clients[i].done = 0;
+        clients[i].start = realloc(clients[i].start, depth * sizeof(double));
+        if (clients[i].start == NULL || !round_trip(&clients[i], "new")) {
+            printf("Could not create queue for connection %d\n", i);
+            exit(1);
+        }
+        pfds[i].fd = clients[i].fd;
+        pfds[i].events = POLLIN;
+    }
+
+    double start = now();
+    for (i = 0; i < nconns; i++)
+        send_batch(&clients[i], depth < nreqs ? depth : nreqs, depth);
+    int active = nconns;
+    while (active > 0) {
+        if (poll(pfds, nconns, -1) < 0) {
+            perror("poll");
+            exit(1);
+        }
+        for (i = 0; i < nconns; i++) {
+            client_t *cp = &clients[i];
+            if (pfds[i].fd < 0 || !(pfds[i].revents & (POLLIN | POLLHUP)))
+                continue;
+            bool err = false;
+            int r = read_responses(cp, &err);
+            if (r < 0) {
+                printf("Server closed connection %d\n", i);
+                exit(1);
+            }
+            if (err)
+                nerrors++;
+            if (r == 0)
+                continue;
+            /* All responses in this read arrived at the same time */
+            double t = now();
+            for (j = 0; j < r; j++) {
+                latencies[nlatencies++] = t - cp->start[cp->done % depth];
+                cp->done++;
+            }
+            int refill = nreqs - cp->sent;
+            if (refill > r)
+                refill = r;
+            if (refill > 0)
+                send_batch(cp, refill, depth);
+            else if (cp->done == nreqs) {
+                pfds[i].fd = -1;
+                active--;
+            }
+        }
+    }
+    double elapsed = now() - start;
+
+    qsort(latencies, nlatencies, sizeof(double), compare_double);
+    double sum = 0.0;
+    for (i = 0; i < nlatencies; i++)
+        sum += latencies[i];
+    printf("%5d\t%8d\t%6d\t%7.3f\t%10.0f\t%8.1f\t%8.1f\t%8.1f\t%8.1f\n",
+           depth, nlatencies, nerrors, elapsed, nlatencies / elapsed,
+           1.0E6 * sum / nlatencies,
+           1.0E6 * latencies[nlatencies / 2],
+           1.0E6 * latencies[(int) (0.99 * (nlatencies - 1))],
+           1.0E6 * latencies[nlatencies - 1]);
+}
+
+/* Parse comma-separated list of pipeline depths */
+static bool get_depths(char *list) {
+    char *tok;
+    ndepths = 0;
+    for (tok = strtok(list, ","); tok; tok = strtok(NULL, ",")) {
+        if (ndepths == MAXDEPTHS)
+            return false;
+        depths[ndepths] = atoi(tok);
+        if (depths[ndepths] < 1)
+            return false;
+        ndepths++;
+    }
+    return ndepths > 0;
+}
+
+int main(int argc, char *argv[]) {
+    int c, i;
+    char buf[BUFSIZE];
+    while ((c = getopt(argc, argv, "hs:c:n:m:p:v:")) != -1) {
+        switch(c) {
+        case 'h':
+            usage(argv[0]);
+            break;
+        case 's':
+            sock_name = optarg;
+            break;
+        case 'c':
+            nconns = atoi(optarg);
+            break;
+        case 'n':
+            nreqs = atoi(optarg);
+            break;
+        case 'm':
+            command = optarg;
+            break;
+        case 'p':
+            if (!get_depths(optarg)) {
+                printf("Invalid pipeline depths '%s'\n", optarg);
+                usage(argv[0]);
+            }
+            break;
+        case 'v':
+            vlevel = atoi(optarg);
+            break;
+        default:
+            printf("Unknown option '%c'\n", c);
+            usage(argv[0]);
+            break;
+        }
+    }
+    if (sock_name == NULL || nconns < 1 || nreqs < 1)
+        usage(argv[0]);
+
+    client_t *clients = calloc(nconns, sizeof(client_t));
+    struct pollfd *pfds = calloc(nconns, sizeof(struct pollfd));
+    latencies = calloc((size_t) nconns * nreqs, sizeof(double));
+    if (!clients || !pfds || !latencies) {
+        printf("Could not allocate space for %d connections\n", nconns);
+        exit(1);
+    }
+
+    /* Each connection gets its own queue on the server */
+    for (i = 0; i < nconns; i++)
+        clients[i].fd = connect_server();
+    /* Verbosity is shared by the whole server, so put it back afterward */
+    int old_vlevel = get_verbose(&clients[0]);
+    snprintf(buf, BUFSIZE, "option verbose %d", vlevel);
+    round_trip(&clients[0], buf);
+
+    printf("%d connections x %d requests of '%s'\n", nconns, nreqs, command);
+    printf("Depth\tRequests\tErrors\tSecs\tReq/s\t\tMean(us)\tp50(us)\t\tp99(us)\t\tMax(us)\n");
+    for (i = 0; i < ndepths; i++)
+        run_depth(clients, pfds, depths[i]);
+
+    snprintf(buf, BUFSIZE, "option verbose %d", old_vlevel);
+    round_trip(&clients[0], buf);
+    for (i = 0; i < nconns; i++) {
+        round_trip(&clients[i], "free");
+        close(clients[i].fd);
+    }
+    return 0;
+}
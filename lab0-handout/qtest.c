@@ -23,6 +23,7 @@
 
 #include "report.h"
 #include "console.h"
+#include "server.h"
 
 /***** Settable parameters *****/
 
@@ -65,25 +66,26 @@ static void queue_init();
 static void console_init() {
     add_cmd("new", do_new,
             "                | Create new queue");
-    add_cmd("free", do_free,
-            "                | Delete queue");
-    add_cmd("ih", do_insert_head,
-            " str [n]        | Insert string str at head of queue n times (default: n == 1)");
-    add_cmd("it", do_insert_tail,
-            " str [n]        | Insert string str at tail of queue n times (default: n == 1)");
+    add_async_cmd("free", do_free,
+                  "                | Delete queue");
+    add_async_cmd("ih", do_insert_head,
+                  " str [n]        | Insert string str at head of queue n times (default: n == 1)");
+    add_async_cmd("it", do_insert_tail,
+                  " str [n]        | Insert string str at tail of queue n times (default: n == 1)");
     add_cmd("rh", do_remove_head,
             " [str]          | Remove from head of queue.  Optionally compare to expected value str");
     add_cmd("rhq", do_remove_head_quiet,
             "                | Remove from head of queue without reporting value.");
-    add_cmd("reverse", do_reverse,
-            "                | Reverse queue");
-    add_cmd("size", do_size,
-            " [n]            | Compute queue size n times (default: n == 1)");
+    add_async_cmd("reverse", do_reverse,
+                  "                | Reverse queue");
+    add_async_cmd("size", do_size,
+                  " [n]            | Compute queue size n times (default: n == 1)");
     add_cmd("show", do_show,
-            "                | Show queue contents");
+            " [lo..hi]       | Show queue contents (optionally elements lo through hi)");
     add_param("length", &string_length, "Maximum length of displayed string", NULL);
     add_param("malloc", &fail_probability, "Malloc failure probability percent", NULL);
     add_param("fail", &fail_limit, "Number of times allow queue operations to return false", NULL);
+    add_param("timelimit", &time_limit, "Maximum milliseconds for each queue operation (0 = unlimited)", NULL);
 }
 
 bool do_new(int argc, char *argv[])
@@ -396,53 +398,101 @@ bool do_size(int argc, char *argv[])
     return ok && !error_check();
 }
 
-static bool show_queue(int vlevel)
+/*
+  Display queue elements lo through hi (at most big_queue_size of them)
+  and check that the list holds no more than qcnt elements.
+  If check_all is set, the walk continues to the end of the list.
+  Otherwise it stops after element hi, so that a window of a very
+  long queue can be displayed cheaply.
+  Brent's algorithm detects a cycle after at most 2*(mu+lambda) steps,
+  where mu is the length of the lead-in to the cycle and lambda its length.
+*/
+static bool show_queue_range(int vlevel, size_t lo, size_t hi, bool check_all)
 {
     bool ok = true;
+    bool cycle = false;
     if (verblevel < vlevel)
         return true;
-    int cnt = 0;
+    size_t cnt = 0;
+    size_t shown = 0;
     if (q == NULL) {
         report(vlevel, "q = NULL");
         return true;
     }
-    report_noreturn(vlevel, "q = [");
+    report_noreturn(vlevel, lo > 0 ? "q = [ ..." : "q = [");
     list_ele_t *e = q->head;
+    /* Brent's algorithm: tortoise teleports to e at each power of two */
+    list_ele_t *tortoise = e;
+    size_t power = 1;
+    size_t lam = 0;
     if (exception_setup(true)) {
-        while (ok && e && cnt < qcnt) {
-            if (cnt < big_queue_size)
+        while (ok && e && cnt < qcnt && (check_all || cnt <= hi)) {
+            if (cnt >= lo && cnt <= hi && shown < big_queue_size) {
                 report_noreturn(vlevel, cnt == 0 ? "%s" : " %s", e->value);
+                shown++;
+            }
             e = e->next;
             cnt++;
             ok = ok && !error_check();
+            if (e == tortoise) {
+                cycle = true;
+                break;
+            }
+            if (++lam == power) {
+                tortoise = e;
+                power *= 2;
+                lam = 0;
+            }
         }
     }
     exception_cancel();
+    /* An exception caught by exception_setup is counted as an error */
+    ok = ok && !error_check();
     if (!ok) {
         report(vlevel, " ... ]");
         return false;
     }
     if (e == NULL) {
-        if (cnt <= big_queue_size)
+        if (cnt <= lo)
+            report(vlevel, lo > 0 ? " ]" : "]");
+        else if (shown == cnt - lo)
             report(vlevel, "]");
         else
             report(vlevel, " ... ]");
-    } else {
+    } else if (cycle) {
+        report(vlevel, " ... ]");
+        report(vlevel, "ERROR:  List has cycle (detected after %lu elements)",
+               (unsigned long) cnt);
+        ok = false;
+    } else if (cnt >= qcnt) {
         report(vlevel, " ... ]");
         report(vlevel, "ERROR:  Either list has cycle, or queue has more than %d elements",
                qcnt);
         ok = false;
+    } else {
+        /* Stopped after window */
+        report(vlevel, " ... ]");
     }
     return ok;
 }
 
+static bool show_queue(int vlevel)
+{
+    return show_queue_range(vlevel, 0, big_queue_size - 1, true);
+}
+
 bool do_show(int argc, char *argv[])
 {
-    if (argc != 1) {
-        report(1, "%s takes no arguments", argv[0]);
+    int lo, hi;
+    int len = 0;
+    if (argc == 1)
+        return show_queue(0);
+    if (argc != 2 || sscanf(argv[1], "%d..%d%n", &lo, &hi, &len) != 2
+        || argv[1][len] != '\0' || lo < 0 || hi < lo) {
+        report(1, "%s takes no arguments or a range lo..hi", argv[0]);
         return false;
     }
-    return show_queue(0);
+    return show_queue_range(0, lo, hi, false);
 }
 
 /* Signal handlers */
@@ -451,10 +501,57 @@ void sigsegvhandler(int sig) {
 }
 
 void sigalrmhandler(int sig) {
-    trigger_exception("Time limit exceeded.  Either you are in an infinite loop, or your code is too inefficient");
+    trigger_time_exception("Time limit exceeded.  Either you are in an infinite loop, or your code is too inefficient");
 }
 
 
+/*
+  Queue state for each network connection.
+  Installed in the global variables while executing its commands.
+*/
+typedef struct {
+    queue_t *q;
+    size_t qcnt;
+    int fail_count;
+    alloc_state_t alloc;
+} queue_state_t;
+
+static void *new_queue_state() {
+    queue_state_t *sp = malloc_or_fail(sizeof(queue_state_t), "new_queue_state");
+    sp->q = NULL;
+    sp->qcnt = 0;
+    sp->fail_count = 0;
+    sp->alloc.allocated = NULL;
+    sp->alloc.allocated_count = 0;
+    return sp;
+}
+
+static void swap_queue_state(void *state) {
+    queue_state_t *sp = (queue_state_t *) state;
+    queue_t *tq = q;
+    q = sp->q;
+    sp->q = tq;
+    size_t tcnt = qcnt;
+    qcnt = sp->qcnt;
+    sp->qcnt = tcnt;
+    int tfail = fail_count;
+    fail_count = sp->fail_count;
+    sp->fail_count = tfail;
+    swap_allocation_state(&sp->alloc);
+}
+
+static void free_queue_state(void *state) {
+    swap_queue_state(state);
+    if (qcnt > big_queue_size)
+        set_cautious_mode(false);
+    if (exception_setup(true))
+        q_free(q);
+    exception_cancel();
+    set_cautious_mode(true);
+    swap_queue_state(state);
+    free_block(state, sizeof(queue_state_t));
+}
+
 static void queue_init() {
     fail_count = 0;
     q = NULL;
@@ -481,14 +578,21 @@ static bool queue_quit(int argc, char *argv[]) {
 
 
 static void usage(char *cmd) {
-    printf("Usage: %s [-h] [-f IFILE][-v VLEVEL][-l LFILE]\n",  cmd);
+    printf("Usage: %s [-h] [-f IFILE][-v VLEVEL][-l LFILE][-L SOCK]\n",  cmd);
     printf("\t-h         Print this information\n");
     printf("\t-f IFILE   Read commands from IFILE\n");
     printf("\t-v VLEVEL  Set verbosity level\n");
     printf("\t-l LFILE   Echo results to LFILE\n");
+    printf("\t-L SOCK    (--listen) Also serve commands on Unix-domain socket SOCK.\n");
+    printf("\t           Each connection gets its own queue\n");
     exit(0);
 }
 
+static struct option long_options[] = {
+    {"listen", required_argument, NULL, 'L'},
+    {NULL, 0, NULL, 0}
+};
+
 #define BUFSIZE 256
 
 int main(int argc, char *argv[]) {
@@ -497,10 +601,12 @@ int main(int argc, char *argv[]) {
     char *infile_name = NULL;
     char lbuf[BUFSIZE];
     char *logfile_name = NULL;
+    char sbuf[BUFSIZE];
+    char *sock_name = NULL;
     int level = 4;
     int c;
 
-    while ((c = getopt(argc, argv, "hv:f:l:")) != -1) {
+    while ((c = getopt_long(argc, argv, "hv:f:l:L:", long_options, NULL)) != -1) {
         switch(c) {
         case 'h':
             usage(argv[0]);
@@ -518,6 +624,11 @@ int main(int argc, char *argv[]) {
             buf[BUFSIZE-1] = '\0';
             logfile_name = lbuf;
             break;
+        case 'L':
+            strncpy(sbuf, optarg, BUFSIZE);
+            sbuf[BUFSIZE-1] = '\0';
+            sock_name = sbuf;
+            break;
         default:
             printf("Unknown option '%c'\n", c);
             usage(argv[0]);
@@ -533,9 +644,15 @@ int main(int argc, char *argv[]) {
     }
     if (logfile_name)
         set_logfile(logfile_name);
+    /* Connection queues must be freed before checking for leaks */
+    if (sock_name)
+        init_server(new_queue_state, swap_queue_state, free_queue_state);
     add_quit_helper(queue_quit);
     bool ok = true;
-    ok = ok && run_console(infile_name);
+    if (sock_name)
+        ok = ok && open_server(sock_name) && run_server(infile_name);
+    else
+        ok = ok && run_console(infile_name);
     ok = ok && finish_cmd();
     return ok ? 0 : 1;
 }
@@ -0,0 +1,260 @@
+/* Serve command streams over a Unix-domain socket */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "report.h"
+#include "console.h"
+#include "server.h"
+
+/* Maximum length of command line from client */
+#define CONN_BUFSIZE 8192
+
+/* Information about each client connection */
+/* Organized as linked list, most recent first */
+typedef struct CONN_ELE conn_ele, *conn_ptr;
+struct CONN_ELE {
+    int fd;
+    /*
+      Command output & status lines accumulate in memory stream,
+      and are sent with a single write once all commands
+      in the input buffer have been executed.
+    */
+    FILE *out;
+    char *obuf;
+    size_t olen;
+    void *state;            /* Application state for this connection */
+    int cnt;                /* Bytes of partial command in buf */
+    char buf[CONN_BUFSIZE];
+    conn_ptr next;
+};
+
+static conn_ptr conn_list = NULL;
+static int listen_fd = -1;
+static char *listen_path = NULL;
+
+static new_state_function new_state = NULL;
+static swap_state_function swap_state = NULL;
+static free_state_function free_state = NULL;
+
+/* Set by SIGINT/SIGTERM */
+static volatile sig_atomic_t stop_flag = 0;
+
+static void stop_handler(int sig) {
+    stop_flag = 1;
+}
+
+static void close_conn(conn_ptr c) {
+    free_state(c->state);
+    fclose(c->out);
+    free(c->obuf);
+    close(c->fd);
+    free_block(c, sizeof(conn_ele));
+}
+
+/* Quit helper: Close all connections, so that their state is released */
+static bool close_all(int argc, char *argv[]) {
+    while (conn_list) {
+        conn_ptr c = conn_list;
+        conn_list = c->next;
+        close_conn(c);
+    }
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        unlink(listen_path);
+        listen_fd = -1;
+    }
+    return true;
+}
+
+void init_server(new_state_function nsf, swap_state_function ssf,
+                 free_state_function fsf) {
+    new_state = nsf;
+    swap_state = ssf;
+    free_state = fsf;
+    add_quit_helper(close_all);
+}
+
+bool open_server(char *path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        report(1, "Socket path '%s' too long", path);
+        return false;
+    }
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        report(1, "Could not create socket");
+        return false;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    /* Remove stale socket from earlier run */
+    unlink(path);
+    if (bind(listen_fd, (struct sockaddr *) &addr, sizeof(addr)) < 0
+        || listen(listen_fd, SOMAXCONN) < 0) {
+        report(1, "Could not listen on socket '%s'", path);
+        close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+    listen_path = path;
+    report(1, "Listening on %s", path);
+    return true;
+}
+
+static void accept_conn() {
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0)
+        return;
+    conn_ptr c = malloc_or_fail(sizeof(conn_ele), "accept_conn");
+    c->obuf = NULL;
+    c->olen = 0;
+    c->out = open_memstream(&c->obuf, &c->olen);
+    if (c->out == NULL) {
+        free_block(c, sizeof(conn_ele));
+        close(fd);
+        return;
+    }
+    c->fd = fd;
+    c->state = new_state();
+    c->cnt = 0;
+    c->next = conn_list;
+    conn_list = c;
+    report(3, "Opened connection %d", fd);
+}
+
+/*
+  Execute command line on behalf of connection.
+  Return false if client asked to close the connection.
+*/
+static bool serve_cmd(conn_ptr c, char *cmdline) {
+    char name[16] = "";
+    bool ok = false;
+    if (sscanf(cmdline, "%15s", name) == 1 && strcmp(name, "quit") == 0)
+        return false;
+    /*
+      Options such as malloc and seconds also act on the whole process,
+      but they are allowed: a client may set them for its own test,
+      and is expected to restore them, as qload does with verbose.
+    */
+    if (strcmp(name, "source") == 0 || strcmp(name, "log") == 0) {
+        /* These act on the console as a whole */
+        fprintf(c->out, "Command '%s' not available over network\n", name);
+    } else {
+        swap_state(c->state);
+        init_files(c->out, c->out);
+        ok = interpret_remote_cmd(cmdline);
+        init_files(stdout, stdout);
+        swap_state(c->state);
+    }
+    fputs(ok ? "+OK\n" : "-ERR\n", c->out);
+    return true;
+}
+
+/*
+  Send accumulated output to client.
+  Return false if connection failed.
+*/
+static bool flush_output(conn_ptr c) {
+    fflush(c->out);
+    size_t sent = 0;
+    while (sent < c->olen) {
+        ssize_t n = write(c->fd, c->obuf + sent, c->olen - sent);
+        if (n <= 0)
+            break;
+        sent += n;
+    }
+    bool ok = sent == c->olen;
+    rewind(c->out);
+    return ok;
+}
+
+/*
+  Read available input from connection and execute all complete commands.
+  Clients may pipeline commands: all responses to the commands
+  in one read are sent back together.
+  Return false if connection should be closed.
+*/
+static bool serve_input(conn_ptr c) {
+    int n = read(c->fd, c->buf + c->cnt, CONN_BUFSIZE - 1 - c->cnt);
+    if (n <= 0)
+        return false;
+    c->cnt += n;
+    char *start = c->buf;
+    char *end = c->buf + c->cnt;
+    char *nl;
+    bool ok = true;
+    while (ok && (nl = memchr(start, '\n', end - start)) != NULL) {
+        *nl = '\0';
+        ok = serve_cmd(c, start);
+        start = nl + 1;
+    }
+    c->cnt = end - start;
+    memmove(c->buf, start, c->cnt);
+    if (ok && c->cnt == CONN_BUFSIZE - 1) {
+        /* Hit buffer limit.  Artificially terminate line */
+        c->buf[c->cnt] = '\0';
+        c->cnt = 0;
+        ok = serve_cmd(c, c->buf);
+    }
+    return flush_output(c) && ok;
+}
+
+bool run_server(char *infile_name) {
+    if (!start_cmd(infile_name))
+        return false;
+    signal(SIGINT, stop_handler);
+    signal(SIGTERM, stop_handler);
+    /* Client disconnects show up as write errors, not signals */
+    signal(SIGPIPE, SIG_IGN);
+    while (!cmd_quit() && !stop_flag) {
+        fd_set readset;
+        FD_ZERO(&readset);
+        int nfds = 0;
+        conn_ptr c;
+        /*
+          While a console command runs on the worker thread, clients must
+          wait: serving them would swap the queue state it is using.
+          Their input stays queued in the kernel until the job finishes.
+        */
+        if (!cmd_busy()) {
+            FD_SET(listen_fd, &readset);
+            nfds = listen_fd + 1;
+            for (c = conn_list; c; c = c->next) {
+                FD_SET(c->fd, &readset);
+                if (c->fd >= nfds)
+                    nfds = c->fd + 1;
+            }
+        }
+        int result = cmd_select(nfds, &readset, NULL, NULL, NULL);
+        if (result < 0 && errno != EINTR) {
+            report(1, "Select failed in server loop");
+            return false;
+        }
+        /* Command input read by cmd_select may have started a job */
+        if (result <= 0 || cmd_quit() || cmd_busy())
+            continue;
+        if (FD_ISSET(listen_fd, &readset))
+            accept_conn();
+        conn_ptr *last_loc = &conn_list;
+        while ((c = *last_loc) != NULL) {
+            if (FD_ISSET(c->fd, &readset) && !serve_input(c)) {
+                report(3, "Closed connection %d", c->fd);
+                *last_loc = c->next;
+                close_conn(c);
+            } else
+                last_loc = &c->next;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,37 @@
+/* Serve command streams over a Unix-domain socket */
+
+/*
+  Each connection has its own copy of the application state
+  (e.g., the queue being tested).  Application supplies functions to
+  manage that state:
+
+  new_state:  Create state for newly opened connection
+  swap_state: Exchange the installed state with the given one.
+              Calling it twice restores the original state.
+  free_state: Release state of closed connection
+*/
+typedef void *(*new_state_function)();
+typedef void (*swap_state_function)(void *state);
+typedef void (*free_state_function)(void *state);
+
+void init_server(new_state_function new_state, swap_state_function swap_state,
+                 free_state_function free_state);
+
+/* Create listening socket at path.  Return true if successful */
+bool open_server(char *path);
+
+/*
+  Run server loop.
+  Commands from infile_name (stdin if NULL) are interpreted as with
+  run_console, while commands arriving on client connections are executed
+  against each connection's own state.  Every command sent by a client
+  produces its output followed by a status line "+OK" or "-ERR".
+  Clients may pipeline commands, sending many before reading any
+  responses.  Responses are sent in bulk, one write per batch of input.
+  Only the application state is per connection: options set by a client
+  (verbose, malloc, seconds, ...) apply to the whole process, including
+  the console and other clients, until they are set again.
+  Loop continues until a quit command is read from command input, or a
+  SIGINT/SIGTERM signal is received.
+*/
+bool run_server(char *infile_name);
@@ -0,0 +1,27 @@
+/*
+ * CS 208 Lab 1: Data Lab
+ *
+ * batch.c - Batch evaluation of puzzle solutions.
+ *
+ * The reference functions in tests.c are compiled as part of this
+ * file, so that they can be inlined into a loop over an array of
+ * arguments, and the Makefile compiles it with -O3 and -fwrapv.  The
+ * solutions in bits.c are not: they are compiled on their own with
+ * the usual flags and called from the loops, so that a solution whose
+ * result depends on overflow behaves as it does for the student.
+ */
+#include <stdlib.h>
+#include "bits.h"
+#include "tests.c"
+#include "btest.h"
+
+/*
+ * Each kernel evaluates the solution and the reference function on the
+ * argument lists (a1, a2, x[k]) for k = 0..n-1, where x[k] fills the
+ * last argument, and returns the first k where they disagree, or -1.
+ * The results are first combined over the whole array without
+ * branches, so the position of a mismatch is only searched for when
+ * there is one.  The kernels are generated from the puzzle table in
+ * decl.c by genkernels.pl.
+ */
+#include "kernels.c"
@@ -0,0 +1,279 @@
+#!/usr/bin/perl
+#######################################################################
+# batchgrade.pl - Grade many bits.c submissions at once
+#
+# The submissions directory holds a file <name>.c, or a directory
+# <name> containing bits.c, for each student.  The parts of btest
+# that don't depend on bits.c are compiled once and shared.  Each
+# submission then needs only its bits.c compiled and linked with them,
+# and is graded with btest -G.
+# Submissions are built and graded by a pool of worker processes,
+# each under limits on CPU time and memory, and the results are
+# written to a tab-separated table and a JSON file.
+#
+# Usage: batchgrade.pl [-hk] [-j <n>] [-t <secs>] [-m <MB>]
+#                      [-o <report>] <submissions>
+#
+#######################################################################
+
+use strict 'vars';
+use Getopt::Std;
+use JSON::PP;
+use Cwd;
+
+# Same flags as the Makefile
+my $CC = "gcc";
+my $CFLAGS = "-O -Wall";
+my $KFLAGS = "-O3 -fwrapv -ffp-contract=off";
+my $LIBS = "-lm -lpthread";
+
+# Parts of btest that don't depend on bits.c, and the flags they are
+# compiled with
+my %shared = ("btest.c" => "", "decl.c" => "", "bvexpr.c" => "",
+	      "rules.c" => "", "batch.c" => $KFLAGS);
+
+$| = 1;      # Flush stdout each time
+
+#
+# usage - print help message and terminate
+#
+sub usage {
+    printf STDERR "$_[0]\n";
+    printf STDERR "Usage: $0 [-hk] [-j <n>] [-t <secs>] [-m <MB>] [-o <report>] <submissions>\n";
+    printf STDERR "Options:\n";
+    printf STDERR "  -h          Print this message.\n";
+    printf STDERR "  -j <n>      Grade n submissions at a time (default: one per processor).\n";
+    printf STDERR "  -k          Keep the scratch directory.\n";
+    printf STDERR "  -m <MB>     Limit each submission to MB megabytes of memory (default 1024).\n";
+    printf STDERR "  -o <report> Write report.tsv and report.json (default: grades).\n";
+    printf STDERR "  -t <secs>   Limit each submission to secs seconds of CPU time (default 300).\n";
+    die "\n";
+}
+
+##############
+# Main routine
+##############
+my $login = getlogin() || (getpwuid($<))[0] || "unknown";
+my $tmpdir = "/var/tmp/batchgrade.$login.$$";
+my $labdir = getcwd();
+my $subdir;
+my $workers;
+my $cpu_limit = 300;
+my $mem_limit = 1024;
+my $report = "grades";
+my $keep;
+my @names;
+my %source;
+my %result;
+my %running;
+my $name;
+my $entry;
+my $pid;
+my $done;
+
+no strict;
+getopts('hkj:t:m:o:');
+if ($opt_h || @ARGV != 1) {
+    usage();
+}
+$workers = $opt_j || `getconf _NPROCESSORS_ONLN` || 1;
+chomp($workers);
+$cpu_limit = $opt_t if $opt_t;
+$mem_limit = $opt_m if $opt_m;
+$report = $opt_o if $opt_o;
+$keep = $opt_k;
+$subdir = $ARGV[0];
+use strict 'vars';
+
+#
+# Find the submissions
+#
+opendir(DIR, $subdir)
+    or die "$0: ERROR: Could not open directory $subdir.\n";
+foreach $entry (sort readdir(DIR)) {
+    next if $entry =~ /^\./;
+    if (-f "$subdir/$entry" and $entry =~ /^(.+)\.c$/) {
+	$source{$1} = "$subdir/$entry";
+    }
+    elsif (-f "$subdir/$entry/bits.c") {
+	$source{$entry} = "$subdir/$entry/bits.c";
+    }
+}
+closedir(DIR);
+@names = sort keys %source;
+@names > 0
+    or die "$0: ERROR: No submissions in $subdir.\n";
+
+#
+# Compile the shared objects once
+#
+system("mkdir $tmpdir") == 0
+    or die "$0: Could not make scratch directory $tmpdir.\n";
+print "Compiling the shared parts of btest.\n";
+foreach $entry (sort keys %shared) {
+    my $obj = $entry;
+    $obj =~ s/\.c$/.o/;
+    unless (system("$CC $CFLAGS $shared{$entry} -c $labdir/$entry -o $tmpdir/$obj") == 0) {
+	clean($tmpdir);
+	die "$0: Could not compile $entry.\n";
+    }
+}
+
+#
+# Grade the submissions, with at most $workers at a time
+#
+printf("Grading %d submissions, %d at a time.\n", scalar(@names), $workers);
+$done = 0;
+while (@names or %running) {
+    if (@names and keys(%running) < $workers) {
+	$name = shift(@names);
+	$pid = fork();
+	defined($pid)
+	    or die "$0: ERROR: Could not fork.\n";
+	if ($pid == 0) {
+	    exit(grade($name));
+	}
+	$running{$pid} = $name;
+	next;
+    }
+    $pid = wait();
+    next unless exists($running{$pid});
+    $name = delete($running{$pid});
+    $result{$name} = read_result($name);
+    printf("%d/%d\t%s\t%s\n", ++$done, scalar(keys %source), $name,
+	   $result{$name}->{status});
+}
+
+write_report();
+print "Wrote $report.tsv and $report.json.\n";
+if ($keep) {
+    print "Scratch files are in $tmpdir.\n";
+}
+else {
+    clean($tmpdir);
+}
+exit;
+
+##################
+# Helper functions
+#
+
+#
+# grade - Build and grade submission $name in its own directory.
+# Runs in a worker process.  The status is left in the file status,
+# and the scores in grade.json
+#
+sub grade {
+    my $name = shift;
+    my $dir = "$tmpdir/sub" . $$;
+    my $status;
+
+    mkdir($dir) and chdir($dir)
+	or return 1;
+    open(NAME, ">name") and print NAME "$name\n" and close(NAME);
+    set_status("ok");
+    unless (system("cp '$source{$name}' bits.c") == 0) {
+	set_status("could not copy");
+	return 0;
+    }
+
+    # bits.c gets the same flags as in the Makefile, and none of the
+    # batch kernel flags
+    unless (system("$CC $CFLAGS -o btest bits.c $tmpdir/*.o $LIBS > build.log 2>&1") == 0) {
+	set_status("compile error");
+	return 0;
+    }
+
+    # Each function is tested in a child process, so that one that
+    # crashes or loops forever only costs its own points.  The shell
+    # sets the limits, and the wall clock limit covers a submission
+    # that sleeps
+    $status = system("sh -c 'ulimit -t $cpu_limit -v " . $mem_limit * 1024
+		     . "; exec timeout " . 2 * $cpu_limit
+		     . " ./btest -G -F -j 1' > grade.json 2> btest.err");
+    if ($status != 0) {
+	set_status(($status >> 8) == 124 ? "timed out" : "btest failed");
+    }
+    return 0;
+}
+
+sub set_status {
+    open(STATUS, ">status") and print STATUS "$_[0]\n" and close(STATUS);
+}
+
+#
+# read_result - Collect the results of submission $name from the
+# directory of the worker that graded it
+#
+sub read_result {
+    my $name = shift;
+    my $dir;
+    my $result = {status => "not graded"};
+    my $json;
+
+    foreach $dir (glob("$tmpdir/sub*")) {
+	next unless open(NAME, "$dir/name");
+	my $found = <NAME>;
+	close(NAME);
+	chomp($found);
+	next unless $found eq $name;
+	if (open(STATUS, "$dir/status")) {
+	    $result->{status} = <STATUS>;
+	    chomp($result->{status});
+	    close(STATUS);
+	}
+	if ($result->{status} eq "ok" and open(JSON, "$dir/grade.json")) {
+	    $json = join("", <JSON>);
+	    close(JSON);
+	    $result->{grades} = eval { decode_json($json) };
+	    $result->{status} = "bad output" unless $result->{grades};
+	}
+	elsif ($result->{status} eq "compile error" and open(LOG, "$dir/build.log")) {
+	    $result->{log} = join("", <LOG>);
+	    close(LOG);
+	}
+	rename($dir, "$tmpdir/$name.done");
+	last;
+    }
+    return $result;
+}
+
+#
+# write_report - Write the table of scores and the JSON file with the
+# score of every puzzle, and the compiler messages of submissions that
+# didn't compile
+#
+sub write_report {
+    my $name;
+    my $g;
+
+    open(TSV, ">$report.tsv")
+	or die "$0: ERROR: Could not write $report.tsv.\n";
+    print TSV "Submission\tStatus\tCorr\tPerf\tTotal\tOps\n";
+    foreach $name (sort keys %result) {
+	$g = $result{$name}->{grades};
+	if ($g) {
+	    printf TSV ("%s\t%s\t%d\t%d\t%d\t%d\n", $name,
+			$result{$name}->{status}, $g->{correctness},
+			$g->{performance}, $g->{correctness} + $g->{performance},
+			$g->{ops});
+	}
+	else {
+	    printf TSV ("%s\t%s\t0\t0\t0\t-\n", $name, $result{$name}->{status});
+	}
+    }
+    close(TSV);
+
+    open(JSON, ">$report.json")
+	or die "$0: ERROR: Could not write $report.json.\n";
+    print JSON JSON::PP->new->pretty->canonical->encode(\%result);
+    close(JSON);
+}
+
+#
+# clean - remove the scratch directory
+#
+sub clean {
+    my $tmpdir = shift;
+    system("rm -rf $tmpdir");
+}
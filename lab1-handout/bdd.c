@@ -0,0 +1,231 @@
+/*
+ * CS 208 Lab 1: Data Lab
+ *
+ * bdd.c - Reduced, ordered binary decision diagrams
+ *
+ * Nodes are kept in a single array, and hash-consed through a chained
+ * unique table.  Results of ITE operations are remembered in a
+ * direct-mapped cache, so that each distinct subproblem is normally
+ * solved only once.  There is no garbage collection: tables are cleared
+ * as a whole by bdd_reset.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bdd.h"
+
+/* Level of the terminal nodes, below every variable */
+#define TERMINAL_VAR 0x7fffffff
+
+typedef struct {
+    int var;
+    int lo, hi;             /* Children for var = 0 and var = 1 */
+    int next;               /* Next node in unique table chain */
+} node_t;
+
+/* Entry in the operation cache */
+typedef struct {
+    int i, t, e;
+    int result;
+} cache_t;
+
+static node_t *nodes = NULL;
+static int nnodes = 0;
+static int alloc_nodes = 0;
+static int limit_nodes = 0;
+
+/* Unique table has hash_size chains, with hash_size a power of 2 */
+static int *hash_table = NULL;
+static int hash_size = 0;
+
+static cache_t *cache = NULL;
+static int cache_size = 0;
+
+/* ITE calls that missed the cache since bdd_reset.  When the cache
+   thrashes, the work can grow much faster than the number of nodes */
+static long long steps = 0;
+static long long limit_steps = 0;
+
+int bdd_overflow = 0;
+
+#define INITIAL_NODES (1 << 16)
+
+/* Work allowed per node of the limit */
+#define STEPS_PER_NODE 64
+
+static void *bdd_alloc(size_t size) {
+    void *p = calloc(1, size);
+    if (!p) {
+	printf("Couldn't allocate space for BDD tables\n");
+	exit(1);
+    }
+    return p;
+}
+
+static unsigned hash3(int a, int b, int c) {
+    unsigned h = a * 12582917u + b * 4256249u + c * 741457u;
+    return h ^ (h >> 15);
+}
+
+/* Grow node array, unique table and cache together */
+static void grow_tables(int size) {
+    int i;
+    node_t *new_nodes = bdd_alloc(size * sizeof(node_t));
+    memcpy(new_nodes, nodes, nnodes * sizeof(node_t));
+    free(nodes);
+    nodes = new_nodes;
+    alloc_nodes = size;
+
+    free(hash_table);
+    for (hash_size = 1; hash_size < size; hash_size *= 2)
+	;
+    hash_table = bdd_alloc(hash_size * sizeof(int));
+    for (i = 0; i < hash_size; i++)
+	hash_table[i] = -1;
+    for (i = 2; i < nnodes; i++) {
+	unsigned h = hash3(nodes[i].var, nodes[i].lo, nodes[i].hi) & (hash_size-1);
+	nodes[i].next = hash_table[h];
+	hash_table[h] = i;
+    }
+
+    free(cache);
+    cache_size = hash_size;
+    cache = bdd_alloc(cache_size * sizeof(cache_t));
+    for (i = 0; i < cache_size; i++)
+	cache[i].i = -1;
+}
+
+void bdd_reset(int max_nodes) {
+    free(nodes);
+    nodes = NULL;
+    nnodes = 0;
+    limit_nodes = max_nodes;
+    grow_tables(INITIAL_NODES < max_nodes ? INITIAL_NODES : max_nodes);
+    nodes[BDD_FALSE].var = nodes[BDD_TRUE].var = TERMINAL_VAR;
+    nnodes = 2;
+    steps = 0;
+    limit_steps = (long long) STEPS_PER_NODE * max_nodes;
+    bdd_overflow = 0;
+}
+
+int bdd_node_count() {
+    return nnodes;
+}
+
+/* Find or create the node (var, lo, hi) */
+static int make_node(int var, int lo, int hi) {
+    unsigned h;
+    int n;
+
+    if (lo == hi)
+	return lo;
+    h = hash3(var, lo, hi) & (hash_size-1);
+    for (n = hash_table[h]; n >= 0; n = nodes[n].next)
+	if (nodes[n].var == var && nodes[n].lo == lo && nodes[n].hi == hi)
+	    return n;
+    if (nnodes == alloc_nodes) {
+	if (alloc_nodes >= limit_nodes) {
+	    bdd_overflow = 1;
+	    return BDD_FALSE;
+	}
+	grow_tables(2 * alloc_nodes < limit_nodes ? 2 * alloc_nodes : limit_nodes);
+	h = hash3(var, lo, hi) & (hash_size-1);
+    }
+    n = nnodes++;
+    nodes[n].var = var;
+    nodes[n].lo = lo;
+    nodes[n].hi = hi;
+    nodes[n].next = hash_table[h];
+    hash_table[h] = n;
+    return n;
+}
+
+int bdd_var(int v) {
+    return make_node(v, BDD_FALSE, BDD_TRUE);
+}
+
+/* Cofactor of f with respect to top variable var */
+static int cofactor(int f, int var, int val) {
+    if (nodes[f].var != var)
+	return f;
+    return val ? nodes[f].hi : nodes[f].lo;
+}
+
+int bdd_ite(int i, int t, int e) {
+    int var, lo, hi, result;
+    unsigned h;
+
+    /* Terminal cases */
+    if (i == BDD_TRUE || t == e)
+	return t;
+    if (i == BDD_FALSE)
+	return e;
+    if (t == BDD_TRUE && e == BDD_FALSE)
+	return i;
+    if (bdd_overflow)
+	return BDD_FALSE;
+
+    h = hash3(i, t, e) & (cache_size-1);
+    if (cache[h].i == i && cache[h].t == t && cache[h].e == e)
+	return cache[h].result;
+    if (++steps > limit_steps) {
+	bdd_overflow = 1;
+	return BDD_FALSE;
+    }
+
+    /* Split on the top variable of the three */
+    var = nodes[i].var;
+    if (nodes[t].var < var)
+	var = nodes[t].var;
+    if (nodes[e].var < var)
+	var = nodes[e].var;
+    lo = bdd_ite(cofactor(i, var, 0), cofactor(t, var, 0), cofactor(e, var, 0));
+    hi = bdd_ite(cofactor(i, var, 1), cofactor(t, var, 1), cofactor(e, var, 1));
+    result = make_node(var, lo, hi);
+
+    /* Tables may have grown */
+    h = hash3(i, t, e) & (cache_size-1);
+    cache[h].i = i;
+    cache[h].t = t;
+    cache[h].e = e;
+    cache[h].result = result;
+    return result;
+}
+
+int bdd_not(int a) {
+    return bdd_ite(a, BDD_FALSE, BDD_TRUE);
+}
+
+int bdd_and(int a, int b) {
+    return bdd_ite(a, b, BDD_FALSE);
+}
+
+int bdd_or(int a, int b) {
+    return bdd_ite(a, BDD_TRUE, b);
+}
+
+int bdd_xor(int a, int b) {
+    return bdd_ite(a, bdd_not(b), b);
+}
+
+int bdd_satisfy(int f, char vals[], int nvars) {
+    memset(vals, 0, nvars);
+    if (f == BDD_FALSE)
+	return 0;
+    /* In a reduced BDD, every node other than FALSE leads to TRUE */
+    while (f != BDD_TRUE) {
+	if (nodes[f].lo != BDD_FALSE)
+	    f = nodes[f].lo;
+	else {
+	    vals[nodes[f].var] = 1;
+	    f = nodes[f].hi;
+	}
+    }
+    return 1;
+}
+
+int bdd_eval(int f, char vals[]) {
+    while (f != BDD_FALSE && f != BDD_TRUE)
+	f = vals[nodes[f].var] ? nodes[f].hi : nodes[f].lo;
+    return f == BDD_TRUE;
+}
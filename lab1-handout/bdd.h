@@ -0,0 +1,47 @@
+/*
+ * CS 208 Lab 1: Data Lab
+ *
+ * bdd.h - Reduced, ordered binary decision diagrams
+ *
+ * A BDD is referred to by the index of its root node.  Nodes are
+ * hash-consed through a unique table, so that two functions are equal
+ * exactly when their BDDs have the same index.  Variable 0 is at the
+ * top of the ordering.
+ */
+
+#define BDD_FALSE 0
+#define BDD_TRUE  1
+
+/* Start over with an empty table of at most max_nodes nodes */
+void bdd_reset(int max_nodes);
+
+/*
+ * Set when an operation could not be completed because the node limit
+ * was reached, or the operations since bdd_reset had done too much
+ * work for that limit.  From then on, results are meaningless until the next
+ * bdd_reset.
+ */
+extern int bdd_overflow;
+
+/* Number of nodes in use */
+int bdd_node_count();
+
+/* Function that is true when variable v is 1 */
+int bdd_var(int v);
+
+int bdd_not(int a);
+int bdd_and(int a, int b);
+int bdd_or(int a, int b);
+int bdd_xor(int a, int b);
+/* If-then-else: (i & t) | (~i & e) */
+int bdd_ite(int i, int t, int e);
+
+/*
+ * Find an assignment to variables 0..nvars-1 for which f is true,
+ * storing it in vals.  Variables that don't matter are set to 0.
+ * Return 0 if f is unsatisfiable.
+ */
+int bdd_satisfy(int f, char vals[], int nvars);
+
+/* Value of f for the assignment in vals */
+int bdd_eval(int f, char vals[]);
@@ -0,0 +1,437 @@
+/*
+ * CS 208 Lab 1: Data Lab
+ *
+ * bddcheck.c - Prove that the solutions in bits.c are correct.
+ *
+ * Where btest runs each solution on a large sample of arguments,
+ * bddcheck parses the source of the solution and of its reference
+ * function in tests.c, and builds a binary decision diagram for every
+ * bit of their results, with a diagram variable for every bit of the
+ * arguments.  The two functions agree on all arguments within the
+ * test ranges exactly when the diagram for their difference is false.
+ * Otherwise the diagram yields a counterexample, which is reported in
+ * the same way as btest does.
+ *
+ * With -S, the logic is instead encoded as clauses for the SAT solver
+ * in sat.c, which asks for arguments where the results differ.  This
+ * copes with some functions whose diagrams would be too large.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "btest.h"
+#include "bdd.h"
+#include "sat.h"
+#include "bvexpr.h"
+
+/* Most BDD nodes used to check a single function */
+#define NODE_LIMIT 4000000
+
+/* Most conflicts for the SAT solver to check a single function */
+#define CONFLICT_LIMIT 1000000
+
+/* Arguments with fewer than this many possible values come first in
+   the variable ordering */
+#define SMALL_RANGE 256
+
+/* Maximum number of arguments */
+#define MAX_ARGS 3
+
+/* Arguments tried together when every argument is tried */
+#define BLOCK_SIZE 1024
+
+/* Defined in decl.c */
+extern test_rec test_set[];
+
+/* Emit results in a format for autograding, without showing
+   counterexamples (-g) */
+static int grade = 0;
+
+/* If non-NULL, check only one function (-f) */
+static char *test_fname = NULL;
+
+/* Use fixed weight for rating (-r) */
+static int global_rating = 0;
+
+/* Show size of diagrams (-v) */
+static int verbose = 0;
+
+/* Use SAT solver instead of BDDs (-S) */
+static int use_sat = 0;
+
+static bit_ops_t bdd_ops = {
+    BDD_FALSE, BDD_TRUE, bdd_not, bdd_and, bdd_or, bdd_xor, bdd_ite
+};
+
+static bit_ops_t sat_ops = {
+    SAT_FALSE, SAT_TRUE, sat_not, sat_and, sat_or, sat_xor, sat_ite
+};
+
+/* Variable for argument bit with given position in the ordering */
+static int arg_var(int index) {
+    return use_sat ? sat_new_var() : bdd_var(index);
+}
+
+/*
+ * Assign diagram variables to the bits of the arguments.  Arguments
+ * with small ranges, such as shift amounts, go first, so that the
+ * rest of the diagram splits into a few simple cases.  The bits of
+ * the other arguments are interleaved, most significant first, which
+ * keeps adders and comparisons linear in size.  The SAT solver
+ * doesn't depend on the order.  Return number of variables
+ */
+static int make_args(test_ptr t, func_ptr f, bv_t args[]) {
+    int small[MAX_ARGS];
+    int nvars = 0;
+    int i, b, width = 0;
+
+    for (i = 0; i < t->args; i++) {
+	args[i].type = bv_func_param_type(f, i);
+	small[i] = (long long) t->arg_ranges[i][1] - t->arg_ranges[i][0]
+	    < SMALL_RANGE;
+	if (args[i].type.width > width)
+	    width = args[i].type.width;
+    }
+    for (i = 0; i < t->args; i++)
+	if (small[i])
+	    for (b = args[i].type.width - 1; b >= 0; b--)
+		args[i].bits[b] = arg_var(nvars++);
+    for (b = width - 1; b >= 0; b--)
+	for (i = 0; i < t->args; i++)
+	    if (!small[i] && b < args[i].type.width)
+		args[i].bits[b] = arg_var(nvars++);
+    return nvars;
+}
+
+/* Condition that all arguments are within their test ranges */
+static int in_range(bit_ops_t *ops, test_ptr t, bv_t args[]) {
+    int ok = ops->one;
+    int i;
+
+    for (i = 0; i < t->args; i++) {
+	bv_t lo, hi;
+	bv_const(ops, args[i].type, t->arg_ranges[i][0], &lo);
+	bv_const(ops, args[i].type, t->arg_ranges[i][1], &hi);
+	ok = ops->and(ok, ops->not(bv_less(ops, &args[i], &lo)));
+	ok = ops->and(ok, ops->not(bv_less(ops, &hi, &args[i])));
+    }
+    return ok;
+}
+
+/* Width of function t in bits */
+static int width_of(test_ptr t) {
+    return t->width ? t->width : 32;
+}
+
+/* Low width bits of v, sign extended */
+static long long sext(long long v, int width) {
+    int shift = 64 - width;
+    return (long long) ((unsigned long long) v << shift) >> shift;
+}
+
+/* Value of bit vector for the BDD assignment in vals, or for the
+   solution found by the SAT solver, sign extended */
+static long long value_of(bv_t *v, char vals[]) {
+    int width = v->type.width < 64 ? v->type.width : 64;
+    unsigned long long u = 0;
+    int i;
+    for (i = 0; i < width; i++)
+	if (use_sat ? sat_value(v->bits[i]) : bdd_eval(v->bits[i], vals))
+	    u |= 1ULL << i;
+    return sext(u, width);
+}
+
+/* Call f, which is function t or its reference function, on a.
+   Return the result reduced to the width of t */
+static long long call(test_ptr t, funct_t f, long long a[]) {
+    if (width_of(t) == 64)
+	switch (t->args) {
+	case 0:
+	    return ((lfunct_t) f)();
+	case 1:
+	    return ((lfunct1_t) f)(a[0]);
+	case 2:
+	    return ((lfunct2_t) f)(a[0], a[1]);
+	default:
+	    return ((lfunct3_t) f)(a[0], a[1], a[2]);
+	}
+    switch (t->args) {
+    case 0:
+	return sext(f(), width_of(t));
+    case 1:
+	return sext(((funct1_t) f)(a[0]), width_of(t));
+    case 2:
+	return sext(((funct2_t) f)(a[0], a[1]), width_of(t));
+    default:
+	return sext(((funct3_t) f)(a[0], a[1], a[2]), width_of(t));
+    }
+}
+
+/* Format v in decimal and hex, in buf */
+static char *show_val(char *buf, test_ptr t, long long v) {
+    int width = width_of(t);
+
+    if (width == 64)
+	sprintf(buf, "%lld[0x%llx]", v, v);
+    else
+	sprintf(buf, "%d[0x%llx]", (int) v, v & ((1ULL << width) - 1));
+    return buf;
+}
+
+/*
+ * Report counterexample in vals, running the compiled functions on it
+ */
+static void report_counterexample(test_ptr t, bv_t args[], bv_t *r,
+				  bv_t *rt, char vals[]) {
+    long long a[MAX_ARGS] = {0, 0, 0};
+    long long cr, crt;
+    long long br = sext(value_of(r, vals), width_of(t));
+    long long brt = sext(value_of(rt, vals), width_of(t));
+    char list[256], b1[64], b2[64], b3[64];
+    int i;
+
+    list[0] = '\0';
+    for (i = 0; i < t->args; i++) {
+	a[i] = value_of(&args[i], vals);
+	if (i > 0)
+	    strcat(list, ",");
+	show_val(list + strlen(list), t, a[i]);
+    }
+    cr = call(t, t->solution_funct, a);
+    crt = call(t, t->test_funct, a);
+    printf("ERROR: Test %s(%s) failed...\n", t->name, list);
+    if (cr != crt)
+	printf("...Gives %s. Should be %s\n", show_val(b1, t, cr),
+	       show_val(b2, t, crt));
+    else
+	/* Compiler and checker disagree about the meaning of the code,
+	   which usually means it relies on undefined behavior */
+	printf("...Gives %s. Should be %s\n"
+	       "  (When compiled here, it gives %s, which may depend"
+	       " on undefined behavior)\n", show_val(b1, t, br),
+	       show_val(b2, t, brt), show_val(b3, t, cr));
+}
+
+/*
+ * check_all - Check function t, of one argument, by running it and
+ * its reference function on every argument in its range, in blocks,
+ * with its batch kernel from batch.c.  This is the fallback for
+ * functions that can't be analyzed, such as the floating point
+ * puzzles, whose reference functions use floats.  Return number of
+ * errors
+ */
+static int check_all(test_ptr t) {
+    long long lo = t->arg_ranges[0][0], hi = t->arg_ranges[0][1], v;
+    long long a[MAX_ARGS] = {0, 0, 0};
+    long long cr = 0, crt = 0;
+    batch_funct_t batch = NULL;
+    int x[BLOCK_SIZE];
+    char b1[64], b2[64], b3[64];
+    int i, k, n;
+
+    /* Floating point arguments take every bit pattern */
+    if (lo == 1 && hi == 1) {
+	lo = 0;
+	hi = 0xffffffffLL;
+    }
+    for (i = 0; batch_set[i].name; i++)
+	if (strcmp(batch_set[i].name, t->name) == 0)
+	    batch = batch_set[i].batch_funct;
+    for (v = lo; v <= hi; v += BLOCK_SIZE) {
+	n = hi - v + 1 < BLOCK_SIZE ? hi - v + 1 : BLOCK_SIZE;
+	for (k = 0; k < n; k++)
+	    x[k] = v + k;
+	/* The kernel finds candidates, and each is confirmed with a
+	   scalar call */
+	for (k = 0; k < n; k++) {
+	    if (batch) {
+		int j = batch(0, 0, x + k, n - k);
+		if (j < 0)
+		    break;
+		k += j;
+	    }
+	    a[0] = sext(x[k], width_of(t));
+	    cr = call(t, t->solution_funct, a);
+	    crt = call(t, t->test_funct, a);
+	    if (cr != crt)
+		break;
+	}
+	if (cr != crt) {
+	    if (!grade)
+		printf("ERROR: Test %s(%s) failed...\n...Gives %s. Should be %s\n",
+		       t->name, show_val(b1, t, a[0]), show_val(b2, t, cr),
+		       show_val(b3, t, crt));
+	    return 1;
+	}
+    }
+    if (verbose)
+	printf("%s: %lld arguments tried\n", t->name, hi - lo + 1);
+    return 0;
+}
+
+/*
+ * check_function - Check solution against reference function.
+ * Return number of errors
+ */
+static int check_function(test_ptr t) {
+    char tname[256];
+    func_ptr f, ft;
+    bit_ops_t *ops = use_sat ? &sat_ops : &bdd_ops;
+    bv_t args[MAX_ARGS], r, rt;
+    char vals[MAX_ARGS * BV_MAX_WIDTH];
+    char *msg;
+    int nvars, diff, i;
+
+    if (t->args > MAX_ARGS) {
+	printf("Configuration error: invalid number of args (%d) for function %s\n", t->args, t->name);
+	exit(1);
+    }
+    snprintf(tname, sizeof(tname), "test_%s", t->name);
+    f = bv_find_func(t->name);
+    ft = bv_find_func(tname);
+    if (!f || !ft) {
+	printf("ERROR: Test %s failed.\n  Could not check: %s not found\n",
+	       t->name, f ? tname : t->name);
+	return 1;
+    }
+    if (bv_func_nparams(f) != t->args || bv_func_nparams(ft) != t->args) {
+	printf("ERROR: Test %s failed.\n  Could not check: should take %d arguments\n",
+	       t->name, t->args);
+	return 1;
+    }
+
+    if (use_sat)
+	sat_reset();
+    else
+	bdd_reset(NODE_LIMIT);
+    nvars = make_args(t, f, args);
+    if ((msg = bv_eval_func(f, args, ops, &r))
+	|| (msg = bv_eval_func(ft, args, ops, &rt))) {
+	/* Every argument of a one-argument function can be tried */
+	if (t->args == 1 && width_of(t) <= 32)
+	    return check_all(t);
+	printf("ERROR: Test %s failed.\n  Could not check: %s\n",
+	       t->name, msg);
+	return 1;
+    }
+    diff = ops->zero;
+    /* Results are compared at the width of the function */
+    for (i = 0; i < r.type.width && i < rt.type.width && i < width_of(t); i++)
+	diff = ops->or(diff, ops->xor(r.bits[i], rt.bits[i]));
+    diff = ops->and(diff, in_range(ops, t, args));
+
+    if (use_sat) {
+	int status;
+	sat_assert(diff);
+	status = sat_solve(CONFLICT_LIMIT);
+	if (verbose)
+	    printf("%s: %d variables, %d clauses\n", t->name,
+		   sat_var_count(), sat_clause_count());
+	if (status == SAT_UNKNOWN) {
+	    printf("ERROR: Test %s failed.\n  Could not check: too complex (more than %d conflicts)\n",
+		   t->name, CONFLICT_LIMIT);
+	    return 1;
+	}
+	if (status == SAT_UNSAT)
+	    return 0;
+    } else {
+	if (bdd_overflow) {
+	    printf("ERROR: Test %s failed.\n  Could not check: too complex (more than %d BDD nodes)\n",
+		   t->name, NODE_LIMIT);
+	    return 1;
+	}
+	if (verbose)
+	    printf("%s: %d variables, %d BDD nodes\n", t->name, nvars,
+		   bdd_node_count());
+	if (diff == BDD_FALSE)
+	    return 0;
+	bdd_satisfy(diff, vals, nvars);
+    }
+    if (!grade)
+	report_counterexample(t, args, &r, &rt, vals);
+    return 1;
+}
+
+/*
+ * run_tests - Check series of functions.  Return number of errors
+ */
+static int run_tests(char *bits_file, char *tests_file) {
+    int i;
+    int errors = 0;
+    double points = 0.0;
+    double max_points = 0.0;
+
+    if (!bv_parse_file(bits_file) || !bv_parse_file(tests_file)) {
+	printf("Couldn't read %s or %s\n", bits_file, tests_file);
+	exit(1);
+    }
+
+    printf("Score\tRating\tErrors\tFunction\n");
+    for (i = 0; test_set[i].solution_funct; i++) {
+	int terrors;
+	double tpoints;
+	if (!test_fname || strcmp(test_set[i].name, test_fname) == 0) {
+	    int rating = global_rating ? global_rating : test_set[i].rating;
+	    terrors = check_function(&test_set[i]);
+	    errors += terrors;
+	    tpoints = terrors == 0 ? rating : 0.0;
+	    points += tpoints;
+	    max_points += rating;
+
+	    if (grade || terrors < 1)
+		printf(" %.0f\t%d\t%d\t%s\n",
+		       tpoints, rating, terrors, test_set[i].name);
+	}
+    }
+
+    printf("Total points: %.0f/%.0f\n", points, max_points);
+    return errors;
+}
+
+static void usage(char *cmd) {
+    printf("Usage: %s [-hgvS] [-r <n>] [-f <name>] [<bits file> [<tests file>]]\n", cmd);
+    printf("  -f <name> Check only the named function\n");
+    printf("  -g        Compact output for grading (with no error msgs)\n");
+    printf("  -h        Print this message\n");
+    printf("  -r <n>    Give uniform weight of n for all problems\n");
+    printf("  -v        Show size of each diagram or set of clauses\n");
+    printf("  -S        Use SAT solver instead of BDDs\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[]) {
+    char *bits_file = "bits.c";
+    char *tests_file = "tests.c";
+    int c;
+
+    while ((c = getopt(argc, argv, "hgvSf:r:")) != -1)
+	switch (c) {
+	case 'g':
+	    grade = 1;
+	    break;
+	case 'v':
+	    verbose = 1;
+	    break;
+	case 'S':
+	    use_sat = 1;
+	    break;
+	case 'f':
+	    test_fname = optarg;
+	    break;
+	case 'r':
+	    global_rating = atoi(optarg);
+	    if (global_rating < 0)
+		usage(argv[0]);
+	    break;
+	default:
+	    usage(argv[0]);
+	}
+    if (optind < argc)
+	bits_file = argv[optind++];
+    if (optind < argc)
+	tests_file = argv[optind++];
+
+    run_tests(bits_file, tests_file);
+    return 0;
+}
@@ -52,3 +52,11 @@ int absVal(int);
 int test_absVal(int);
 int isPower2(int);
 int test_isPower2(int);
+unsigned floatNegate(unsigned);
+unsigned test_floatNegate(unsigned);
+unsigned floatScale2(unsigned);
+unsigned test_floatScale2(unsigned);
+unsigned floatInt2Float(int);
+unsigned test_floatInt2Float(int);
+int floatFloat2Int(unsigned);
+int test_floatFloat2Int(unsigned);
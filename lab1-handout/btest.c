@@ -10,18 +10,31 @@
  * This is an improved version of btest that tests large windows
  * around zero and tmin and tmax for integer puzzles, and zero, norm,
  * and denorm boundaries for floating point puzzles.
- * 
- * Note: not 64-bit safe. Always compile with gcc -m32 option.
+ *
+ * Puzzles may work on 8, 16, 32 or 64-bit values, as set by the width
+ * field of their test_rec.
  */
 #include <stdio.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <errno.h>
 #include <limits.h>
 #include <signal.h>
 #include <setjmp.h>
 #include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 #include "btest.h"
+#include "bvexpr.h"
+#include "rules.h"
 
 /* Not declared in some stdlib.h files, so define here */
 float strtof(const char *nptr, char **endptr);
@@ -41,10 +54,11 @@ float strtof(const char *nptr, char **endptr);
    explosion */
 #define TEST_RANGE 500000
 
-/* This defines the maximum size of any test value array. The
-   gen_vals() routine creates k test values for each value of
-   TEST_RANGE, thus MAX_TEST_VALS must be at least k*TEST_RANGE */
-#define MAX_TEST_VALS 13*TEST_RANGE
+/* Arguments with at most this many possible values for each value of
+   their test range are tested on every value.  The generators create
+   k test values for each value of the test range, so that this is
+   more than k */
+#define MAX_TEST_VALS 13
 
 /**********************************
  * Globals defined in other modules 
@@ -69,11 +83,15 @@ static char* test_fname = NULL;
 
 /* Special case when only use fixed argument(s) (-1, -2, or -3) */
 static int has_arg[3] = {0,0,0};
-static unsigned argval[3] = {0,0,0};
+static long long argval[3] = {0,0,0};
+static char *argstr[3];
 
 /* Use fixed weight for rating, and if so, what should it  be? (-r) */
 static int global_rating = 0;
 
+/* Selects the random test values, and the fuzzer's mutations (-s) */
+static unsigned long long test_seed = 0;
+
 /******************
  * Helper functions
  ******************/
@@ -104,212 +122,545 @@ void timeout_handler(int sig) {
     siglongjmp(envbuf, 1);
 }
 
+/*
+ * Test values are kept as long long, whatever the width of the
+ * puzzle, and are sign extended from its width, so that a 32-bit -1
+ * is -1 rather than 0xffffffff.
+ */
+
+/* Width of function t in bits */
+static int width_of(test_ptr t) {
+    return t->width ? t->width : 32;
+}
+
+/* Mask of the low width bits */
+static unsigned long long width_mask(int width) {
+    return width == 64 ? ~0ULL : (1ULL << width) - 1;
+}
+
 /* 
- * random_val - Return random integer value between min and max 
+ * sext - Value of the low width bits of v, sign extended
+ */
+static long long sext(long long v, int width) {
+    int shift = 64 - width;
+    return (long long) ((unsigned long long) v << shift) >> shift;
+}
+
+/*
+ * Test values for each argument come from a generator, rather than
+ * being stored in an array.  The values are numbered from 0, and the
+ * value at any position can be computed directly, so that threads can
+ * generate just the values for their part of the tests, in small
+ * chunks.
  */
-static int random_val(int min, int max)
+#define GEN_FIXED  0   /* A single value, min */
+#define GEN_ALL    1   /* Every value from min to min+count-1 */
+#define GEN_FLOAT  2   /* Windows around floating point boundaries */
+#define GEN_SAMPLE 3   /* Windows around min, max and zero, plus random values */
+#define GEN_LIST   4   /* Values from an array */
+
+/* Number of values generated for each window position.  These are the
+   values of k referenced in the comment for MAX_TEST_VALS */
+#define FLOAT_GROUP 12
+#define SAMPLE_GROUP 5
+
+typedef struct {
+    int kind;
+    long long min, max;
+    int range;              /* Size of windows */
+    unsigned long long seed; /* Selects the random values */
+    long long count;        /* Number of values */
+    long long *list;        /* Values for GEN_LIST */
+} gen_t;
+
+/*
+ * mix64 - The SplitMix64 output function, which scrambles the bits of
+ * a 64-bit counter
+ */
+static unsigned long long mix64(unsigned long long z)
 {
-    double weight = rand()/(double) RAND_MAX;
-    int result = min * (1-weight) + max * weight;
-    return result;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
 }
 
 /* 
- * gen_vals - Generate the integer values we'll use to test a function 
+ * random_val - Return random integer value between min and max.  The
+ * value is a hash of seed and pos, so that it does not depend on which
+ * other values have been generated, or on which thread generates them.
+ * Every value in the range is equally likely: the random 64 bits are
+ * scaled to the range with a multiply, as in Lemire's method, and
+ * rejected in the rare case that they would favor some values
  */
-static int gen_vals(int test_vals[], int min, int max, int test_range, int arg)
+static long long random_val(long long min, long long max,
+			    unsigned long long seed, long long pos)
 {
-    int i;
-    int test_count = 0;
+    unsigned long long x = mix64(seed + (pos + 1) * 0x9e3779b97f4a7c15ULL);
+    unsigned long long size = (unsigned long long) max - min + 1;
+    unsigned __int128 m;
+
+    /* Every 64-bit value */
+    if (size == 0)
+	return x;
+    m = (unsigned __int128) x * size;
+    if ((unsigned long long) m < size) {
+	unsigned long long limit = -size % size;
+	while ((unsigned long long) m < limit) {
+	    x = mix64(x);
+	    m = (unsigned __int128) x * size;
+	}
+    }
+    return min + (long long) (m >> 64);
+}
+
+/* 
+ * gen_init - Set up generator for the integer values we'll use to
+ * test argument arg of a function
+ */
+static void gen_init(gen_t *g, long long min, long long max, int test_range,
+		     int arg, int width, unsigned long long seed)
+{
+    g->min = min;
+    g->max = max;
+    g->range = test_range;
+    g->seed = seed;
 
     /* Special case: If the user has specified a specific function
        argument using the -1, -2, or -3 flags, then simply use this
-       argument and return */
+       argument */
     if (has_arg[arg]) {
-	test_vals[0] = argval[arg];
-	return 1;
+	g->kind = GEN_FIXED;
+	g->min = sext(argval[arg], width);
+	g->count = 1;
+	return;
     }
 
     /* 
-     * Special case: Generate test vals for floating point functions
-     * where the input argument is an unsigned bit-level
-     * representation of a float. For this case we want to test the
-     * regions around zero, the smallest normalized and largest
-     * denormalized numbers, one, and the largest normalized number,
-     * as well as inf and nan.
+     * Special case: Test vals for floating point functions where the
+     * input argument is an unsigned bit-level representation of a
+     * float. For this case we want to test the regions around zero,
+     * the smallest normalized and largest denormalized numbers, one,
+     * and the largest normalized number, as well as inf and nan.
      */
     if ((min == 1 && max == 1)) { 
-	unsigned smallest_norm = 0x00800000;
-	unsigned one = 0x3f800000;
-	unsigned largest_norm = 0x7f000000;
-	
-	unsigned inf = 0x7f800000;
-	unsigned nan =  0x7fc00000;
-	unsigned sign = 0x80000000;
-
 	/* Test range should be at most 1/2 the range of one exponent
 	   value */
 	if (test_range > (1 << 23)) {
-	    test_range = 1 << 23;
-	}
-	
-	/* Functions where the input argument is an unsigned bit-level
-	   representation of a float. The number of tests generated
-	   inside this loop body is the value k referenced in the
-	   comment for the global variable MAX_TEST_VALS. */
-
-	for (i = 0; i < test_range; i++) {
-	    /* Denorms around zero */
-	    test_vals[test_count++] = i; 
-	    test_vals[test_count++] = sign | i;
-	    
-	    /* Region around norm to denorm transition */
-	    test_vals[test_count++] = smallest_norm + i;
-	    test_vals[test_count++] = smallest_norm - i;
-	    test_vals[test_count++] = sign | (smallest_norm + i);
-	    test_vals[test_count++] = sign | (smallest_norm - i);
-	    
-	    /* Region around one */
-	    test_vals[test_count++] = one + i;
-	    test_vals[test_count++] = one - i;
-	    test_vals[test_count++] = sign | (one + i);
-	    test_vals[test_count++] = sign | (one - i);
-	    
-	    /* Region below largest norm */
-	    test_vals[test_count++] = largest_norm - i; 
-	    test_vals[test_count++] = sign | (largest_norm - i); 
-	}
-	
-	/* special vals */
-	test_vals[test_count++] = inf;        /* inf */
-	test_vals[test_count++] = sign | inf; /* -inf */
-	test_vals[test_count++] = nan;        /* nan */
-	test_vals[test_count++] = sign | nan; /* -nan */
-
-	return test_count;
+	    g->range = 1 << 23;
+	}
+	g->kind = GEN_FLOAT;
+	g->count = (long long) FLOAT_GROUP * g->range + 4;
+	return;
     }
 
-
     /*
-     * Normal case: Generate test vals for integer functions
+     * Normal case: Test vals for integer functions
      */
 
-    /* If the range is small enough, then do exhaustively */
-    if (max - MAX_TEST_VALS <= min) {
-	for (i = min; i <= max; i++)
-	    test_vals[test_count++] = i;
-	return test_count;
+    /* If the range is small enough, then do exhaustively.  This covers
+       every 8-bit argument, and 16-bit arguments of functions with
+       one argument */
+    if ((unsigned long long) max - min
+	<= (unsigned long long) MAX_TEST_VALS * test_range) {
+	g->kind = GEN_ALL;
+	g->count = (long long) max - min + 1;
+	return;
     }
 
     /* Otherwise, need to sample.  Do so near the boundaries, around
        zero, and for some random cases. */
-    for (i = 0; i < test_range; i++) {
-
-	/* Test around the boundaries */
-	test_vals[test_count++] = min + i;
-	test_vals[test_count++] = max - i;
-
-	/* If zero falls between min and max, then also test around zero */
-	if (i >= min && i <= max)
-	    test_vals[test_count++] = i;
-	if (-i >= min && -i <= max)
-	    test_vals[test_count++] = -i;
+    g->kind = GEN_SAMPLE;
+    g->count = (long long) SAMPLE_GROUP * test_range;
+}
 
-	/* Random case between min and max */
-	test_vals[test_count++] = random_val(min, max);
+/* 
+ * float_value - Return bit pattern of floating point test value at
+ * position pos
+ */
+static unsigned float_value(gen_t *g, long long pos)
+{
+    unsigned smallest_norm = 0x00800000;
+    unsigned one = 0x3f800000;
+    unsigned largest_norm = 0x7f000000;
+    unsigned inf = 0x7f800000;
+    unsigned nan =  0x7fc00000;
+    unsigned sign = 0x80000000;
+    int i;
 
+    if (pos >= (long long) FLOAT_GROUP * g->range) {
+	/* special vals */
+	switch (pos - (long long) FLOAT_GROUP * g->range) {
+	case 0: return inf;              /* inf */
+	case 1: return sign | inf;       /* -inf */
+	case 2: return nan;              /* nan */
+	default: return sign | nan;      /* -nan */
+	}
+    }
+    i = pos / FLOAT_GROUP;
+    switch (pos % FLOAT_GROUP) {
+    /* Denorms around zero */
+    case 0: return i;
+    case 1: return sign | i;
+    /* Region around norm to denorm transition */
+    case 2: return smallest_norm + i;
+    case 3: return smallest_norm - i;
+    case 4: return sign | (smallest_norm + i);
+    case 5: return sign | (smallest_norm - i);
+    /* Region around one */
+    case 6: return one + i;
+    case 7: return one - i;
+    case 8: return sign | (one + i);
+    case 9: return sign | (one - i);
+    /* Region below largest norm */
+    case 10: return largest_norm - i;
+    default: return sign | (largest_norm - i);
     }
-    return test_count;
 }
 
 /* 
- * test_0_arg - Test a function with zero arguments 
+ * gen_value - Return test value at position pos 
  */
-static int test_0_arg(funct_t f, funct_t ft, char *name)
+static long long gen_value(gen_t *g, long long pos)
 {
-    int r = f();
-    int rt = ft();
-    int error =  (r != rt);
+    int i;
 
-    if (error && !grade)
-	printf("ERROR: Test %s() failed...\n...Gives %d[0x%x]. Should be %d[0x%x]\n", name, r, r, rt, rt);
+    switch (g->kind) {
+    case GEN_FIXED:
+	return g->min;
+    case GEN_ALL:
+	return g->min + pos;
+    case GEN_LIST:
+	return g->list[pos];
+    case GEN_FLOAT:
+	return (int) float_value(g, pos);
+    default:
+	i = pos / SAMPLE_GROUP;
+	switch (pos % SAMPLE_GROUP) {
+	/* Test around the boundaries */
+	case 0: return g->min + i;
+	case 1: return g->max - i;
+	/* If zero falls between min and max, then also test around
+	   zero.  Otherwise, use another random case */
+	case 2:
+	    if (i >= g->min && i <= g->max)
+		return i;
+	    break;
+	case 3:
+	    if (-i >= g->min && -i <= g->max)
+		return -i;
+	    break;
+	default:
+	    break;
+	}
+	/* Random case between min and max */
+	return random_val(g->min, g->max, g->seed, pos);
+    }
+}
 
-    return error;
+/*
+ * Before the sampled tests, each function is tested on all
+ * combinations of a small set of boundary values, where bugs are most
+ * likely: 0, 1, -1, TMin and TMax and their neighbors, every number
+ * with a single bit set or clear, with its negation and the mask
+ * below it, and byte masks.  Functions with fewer than three
+ * arguments are also tested on every number with two bits set.  The
+ * values depend on the width of the function.
+ */
+
+/* Most boundary values */
+#define MAX_BOUNDARY 4096
+
+/* Arguments with at most this many possible values take all of them
+   as boundary values */
+#define SMALL_RANGE 64
+
+typedef struct {
+    long long vals[MAX_BOUNDARY];
+    int n;                  /* Number of boundary values */
+    int n_3;                /* Number used for three arguments */
+} boundary_t;
+
+/* Boundary values for 8, 16, 32 and 64 bits */
+static boundary_t boundary_sets[4];
+
+static void add_boundary(boundary_t *b, long long v, int width) {
+    int i;
+
+    v = sext(v, width);
+    for (i = 0; i < b->n; i++)
+	if (b->vals[i] == v)
+	    return;
+    b->vals[b->n++] = v;
+}
+
+static void init_boundary(boundary_t *b, int width) {
+    unsigned long long tmin = 1ULL << (width - 1);
+    int i, j;
+
+    add_boundary(b, 0, width);
+    add_boundary(b, 1, width);
+    add_boundary(b, -1, width);
+    add_boundary(b, tmin, width);
+    add_boundary(b, tmin - 1, width);
+    add_boundary(b, tmin + 1, width);
+    add_boundary(b, tmin - 2, width);
+    for (i = 0; i < width; i++) {
+	unsigned long long bit = 1ULL << i;
+	add_boundary(b, bit, width);
+	add_boundary(b, ~bit, width);
+	add_boundary(b, -bit, width);
+	add_boundary(b, bit - 1, width);
+    }
+    for (i = 0; i < width; i += 8) {
+	add_boundary(b, 0xffULL << i, width);
+	add_boundary(b, 0x80ULL << i, width);
+	add_boundary(b, 0x7fULL << i, width);
+    }
+    b->n_3 = b->n;
+    for (i = 0; i < width; i++)
+	for (j = i + 1; j < width; j++)
+	    add_boundary(b, (1ULL << i) | (1ULL << j), width);
+}
+
+/* 
+ * get_boundary - Return the boundary values for width bits
+ */
+static boundary_t *get_boundary(int width) {
+    boundary_t *b = &boundary_sets[width == 8 ? 0 : width == 16 ? 1
+				   : width == 32 ? 2 : 3];
+    if (b->n == 0)
+	init_boundary(b, width);
+    return b;
 }
 
 /* 
- * test_1_arg - Test a function with one argument 
+ * gen_init_boundary - Set up generator for the boundary values of
+ * argument arg of a function with args arguments
  */
-static int test_1_arg(funct_t f, funct_t ft, int arg1, char *name)
+static void gen_init_boundary(gen_t *g, long long min, long long max,
+			      int args, int arg, int width)
 {
-    funct1_t f1 = (funct1_t) f;
-    funct1_t f1t = (funct1_t) ft;
-    int r, rt, error;
+    boundary_t *b = get_boundary(width);
+    int n = args == 3 ? b->n_3 : b->n;
+    int i;
 
-    r = f1(arg1);
-    rt = f1t(arg1);
-    error = (r != rt);
-    if (error && !grade)
-	printf("ERROR: Test %s(%d[0x%x]) failed...\n...Gives %d[0x%x]. Should be %d[0x%x]\n", name, arg1, arg1, r, r, rt, rt);
+    g->min = min;
+    g->max = max;
+    if (has_arg[arg]) {
+	g->kind = GEN_FIXED;
+	g->min = sext(argval[arg], width);
+	g->count = 1;
+	return;
+    }
+    if ((unsigned long long) max - min < SMALL_RANGE) {
+	g->kind = GEN_ALL;
+	g->count = (long long) max - min + 1;
+	return;
+    }
+    /* The ends of the range come first */
+    g->kind = GEN_LIST;
+    g->list = malloc((n + 2) * sizeof(long long));
+    if (!g->list) {
+	printf("Couldn't allocate space for test values\n");
+	exit(1);
+    }
+    g->list[0] = min;
+    g->list[1] = max;
+    g->count = 2;
+    for (i = 0; i < n; i++)
+	if (b->vals[i] > min && b->vals[i] < max)
+	    g->list[g->count++] = b->vals[i];
+}
 
-    return error;
+/* 
+ * gen_fill - Store the n test values starting at position pos in vals
+ */
+static void gen_fill(gen_t *g, long long pos, int n, int vals[])
+{
+    unsigned first = (unsigned long long) g->min + pos;
+    int k;
+
+    /* Exhaustive testing needs this to be fast */
+    if (g->kind == GEN_ALL) {
+	for (k = 0; k < n; k++)
+	    vals[k] = first + k;
+	return;
+    }
+    for (k = 0; k < n; k++)
+	vals[k] = gen_value(g, pos + k);
 }
 
 /* 
- * test_2_arg - Test a function with two arguments 
+ * call - Call f, which is function t or its reference function, on
+ * the first t->args of the arguments.  Return its result reduced to
+ * the width of t
  */
-static int test_2_arg(funct_t f, funct_t ft, int arg1, int arg2, char *name)
+static long long call(test_ptr t, funct_t f, long long arg1, long long arg2,
+		      long long arg3)
 {
-    funct2_t f2 = (funct2_t) f;
-    funct2_t f2t = (funct2_t) ft;
-    int r = f2(arg1, arg2);
-    int rt = f2t(arg1, arg2);
-    int error = (r != rt);
+    int width = width_of(t);
+
+    if (width == 64)
+	switch (t->args) {
+	case 0:
+	    return ((lfunct_t) f)();
+	case 1:
+	    return ((lfunct1_t) f)(arg1);
+	case 2:
+	    return ((lfunct2_t) f)(arg1, arg2);
+	default:
+	    return ((lfunct3_t) f)(arg1, arg2, arg3);
+	}
+    switch (t->args) {
+    case 0:
+	return sext(f(), width);
+    case 1:
+	return sext(((funct1_t) f)(arg1), width);
+    case 2:
+	return sext(((funct2_t) f)(arg1, arg2), width);
+    default:
+	return sext(((funct3_t) f)(arg1, arg2, arg3), width);
+    }
+}
 
-    if (error && !grade)
-	printf("ERROR: Test %s(%d[0x%x],%d[0x%x]) failed...\n...Gives %d[0x%x]. Should be %d[0x%x]\n", name, arg1, arg1, arg2, arg2, r, r, rt, rt);
+/* 
+ * show_val - Format value v of function t in decimal and hex, in buf
+ */
+static char *show_val(char *buf, test_ptr t, long long v)
+{
+    int width = width_of(t);
 
-    return error;
+    if (width == 64)
+	sprintf(buf, "%lld[0x%llx]", v, v);
+    else
+	sprintf(buf, "%d[0x%llx]", (int) v, v & width_mask(width));
+    return buf;
 }
 
 /* 
- * test_3_arg - Test a function with three arguments 
+ * show_test - Rerun a failing test of function t, and show it.
+ * Return 1 if it fails
  */
-static int test_3_arg(funct_t f, funct_t ft, 
-		      int arg1, int arg2, int arg3, char *name)
+static int show_test(test_ptr t, long long args[])
 {
-    funct3_t f3 = (funct3_t) f;
-    funct3_t f3t = (funct3_t) ft;
-    int r = f3(arg1, arg2, arg3);
-    int rt = f3t(arg1, arg2, arg3);
-    int error = (r != rt);
+    long long r = call(t, t->solution_funct, args[0], args[1], args[2]);
+    long long rt = call(t, t->test_funct, args[0], args[1], args[2]);
+    char list[256], r_buf[64], rt_buf[64];
+    int i, error = (r != rt);
+
+    if (error && !grade) {
+	list[0] = '\0';
+	for (i = 0; i < t->args; i++) {
+	    if (i > 0)
+		strcat(list, ",");
+	    show_val(list + strlen(list), t, args[i]);
+	}
+	printf("ERROR: Test %s(%s) failed...\n...Gives %s. Should be %s\n",
+	       t->name, list, show_val(r_buf, t, r), show_val(rt_buf, t, rt));
+    }
+    return error;
+}
 
-    if (error && !grade)
-	printf("ERROR: Test %s(%d[0x%x],%d[0x%x],%d[0x%x]) failed...\n...Gives %d[0x%x]. Should be %d[0x%x]\n", name, arg1, arg1, arg2, arg2, arg3, arg3, r, r, rt, rt);
+/*
+ * Test state of a single puzzle.  In parallel mode (-j), it is shared
+ * by all of the threads working on the puzzle.
+ */
+typedef struct {
+    test_ptr t;
+    gen_t gens[3];          /* Test values for each arg */
+    long long counts[3];    /* Number of test values for each arg */
+    /* Lowest index of a failing test, where tests are numbered in
+       the order of the sequential a1/a2/a3 loops.  LLONG_MAX if
+       no test has failed */
+    long long fail_index;
+    int timed_out;
+    int crashed;            /* Signal that killed a test process (-F),
+			       -1 if it exited without a result */
+    int limit;              /* Timeout limit in seconds */
+    /* Arguments of the failing test after shrinking, if have_args */
+    long long fail_args[3];
+    int have_args;
+    /* Fuzzing statistics (-Z) */
+    long long fuzz_runs;
+    int fuzz_kept, fuzz_features;
+    /* Work on the puzzle is split into chunks of the a1 values */
+    int nchunks;
+    int chunks_done;
+    double start;           /* Time when first chunk was started */
+    batch_funct_t batch;    /* Batch kernel, or NULL if none */
+} puzzle_t;
+
+/* Number of worker threads (-j).  Zero means test sequentially */
+static int nthreads = 0;
+
+/* Test one-argument functions on every value in their range (-X) */
+static int exhaustive = 0;
+
+/* Number of values of the last argument evaluated together */
+#define BLOCK_SIZE 1024
+
+/* Functions with more than one argument keep the values of the last
+   argument in a buffer of this size, if they fit, rather than
+   generating them for every combination of the other arguments */
+#define CACHE_SIZE 8192
+
+/* Exhaustive testing of a function may take this many times longer
+   than the timeout limit */
+#define EXHAUSTIVE_TIMEOUT_SCALE 60
+
+/* Measure speed of functions rather than testing them (-B) */
+static int benchmark = 0;
+
+/* Test in child processes, so that crashes are contained (-F) */
+static int forked = 0;
 
-    return error;
+/*
+ * exhaustive_test - Is function t tested on every argument value?
+ * Only if it takes one argument of at most 32 bits, with -X
+ */
+static int exhaustive_test(test_ptr t) {
+    return exhaustive && t->args == 1 && !has_arg[0] && width_of(t) <= 32;
+}
+
+/*
+ * has_boundary - Does function t get tested on boundary values?  Not
+ * if it is tested exhaustively anyway, or it takes floating point
+ * arguments, or the user has chosen its arguments
+ */
+static int has_boundary(test_ptr t) {
+    int i, chosen = 1;
+
+    if (t->args < 1 || exhaustive_test(t))
+	return 0;
+    for (i = 0; i < t->args; i++) {
+	if (t->arg_ranges[i][0] == 1 && t->arg_ranges[i][1] == 1)
+	    return 0;
+	if (!has_arg[i])
+	    chosen = 0;
+    }
+    return !chosen;
 }
 
 /* 
- * test_function - Test a function.  Return number of errors 
+ * prepare_test - Set up generators of test values for function, using
+ * its boundary values if boundary is set
  */
-static int test_function(test_ptr t) {
-    int test_counts[3];    /* number of test values for each arg */
+static void prepare_test(puzzle_t *p, test_ptr t, int boundary) {
     int args = t->args;    /* number of function arguments */
     int arg_test_range[3] = {1, 1, 1}; /* test range for each argument */
-    int i, a1, a2, a3;        
-    int errors = 0;
-
-    /* These are the test values for each arg. Declared with the
-       static attribute so that the array will be allocated in bss
-       rather than the stack */
-    static int arg_test_vals[3][MAX_TEST_VALS]; 
+    int width = width_of(t);
+    int i;
+    int all_vals = exhaustive_test(t);
 
     /* Sanity check on the number of args */
     if (args < 0 || args > 3) {
 	printf("Configuration error: invalid number of args (%d) for function %s\n", args, t->name);
 	exit(1);
     }
+    if (width != 8 && width != 16 && width != 32 && width != 64) {
+	printf("Configuration error: invalid width (%d) for function %s\n", width, t->name);
+	exit(1);
+    }
 
     /* Assign range of argument test vals so as to conserve the total
        number of tests, independent of the number of arguments */
@@ -334,15 +685,350 @@ static int test_function(test_ptr t) {
     if (arg_test_range[2] < 1) 
 	arg_test_range[2] = 1;
 
-    /* Create a test set for each argument */
-    for (i = 0; i < args; i++) {
-	test_counts[i] =  gen_vals(arg_test_vals[i], 
-				   t->arg_ranges[i][0], /* min */
-				   t->arg_ranges[i][1], /* max */
-				   arg_test_range[i],   
-				   i);
+    /* Create a test set for each argument.  Unused arguments get a
+       single dummy value, so that every function has
+       counts[0]*counts[1]*counts[2] tests */
+    p->t = t;
+    p->batch = NULL;
+    for (i = 0; batch_set[i].name; i++)
+	if (strcmp(batch_set[i].name, t->name) == 0)
+	    p->batch = batch_set[i].batch_funct;
+    for (i = 0; i < 3; i++) {
+	gen_t *g = &p->gens[i];
+	if (boundary && i < args)
+	    gen_init_boundary(g, t->arg_ranges[i][0], t->arg_ranges[i][1],
+			      args, i, width);
+	else if (i == 0 && all_vals) {
+	    g->kind = GEN_ALL;
+	    g->min = t->arg_ranges[0][0];
+	    g->count = (long long) t->arg_ranges[0][1] - g->min + 1;
+	    /* Floating point puzzles take every bit pattern */
+	    if (t->arg_ranges[0][0] == 1 && t->arg_ranges[0][1] == 1) {
+		g->min = 0;
+		g->count = 1LL << 32;
+	    }
+	} else if (i < args)
+	    gen_init(g,
+		     t->arg_ranges[i][0], /* min */
+		     t->arg_ranges[i][1], /* max */
+		     arg_test_range[i],   
+		     i, width, (test_seed << 32) + (t - test_set) * 3 + i);
+	else {
+	    g->kind = GEN_FIXED;
+	    g->min = 0;
+	    g->count = 1;
+	}
+	p->counts[i] = g->count;
+    }
+    p->fail_index = LLONG_MAX;
+    p->have_args = 0;
+    p->fuzz_runs = 0;
+    p->fuzz_kept = p->fuzz_features = 0;
+    p->timed_out = 0;
+    p->crashed = 0;
+    p->limit = timeout_limit;
+    if (all_vals)
+	p->limit *= EXHAUSTIVE_TIMEOUT_SCALE;
+    p->nchunks = 0;
+    p->chunks_done = 0;
+    p->start = 0;
+}
+
+/* 
+ * differs - Evaluate one test case quietly.  Return 1 if the solution
+ * and the reference function disagree
+ */
+static int differs(test_ptr t, long long arg1, long long arg2,
+		   long long arg3) {
+    return call(t, t->solution_funct, arg1, arg2, arg3) !=
+	call(t, t->test_funct, arg1, arg2, arg3);
+}
+
+/* Serializes updates to fail_index from different threads */
+static pthread_mutex_t fail_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void record_failure(puzzle_t *p, long long index) {
+    /* No locking in sequential mode, where a timeout could leave
+       the lock held */
+    if (nthreads > 0)
+	pthread_mutex_lock(&fail_lock);
+    if (index < p->fail_index)
+	__atomic_store_n(&p->fail_index, index, __ATOMIC_RELAXED);
+    if (nthreads > 0)
+	pthread_mutex_unlock(&fail_lock);
+}
+
+/* 
+ * differs_last - Like differs, but with x as the function's last
+ * argument
+ */
+static int differs_last(test_ptr t, int a1, int a2, int x) {
+    switch (t->args) {
+    case 1:
+	return differs(t, x, 0, 0);
+    case 2:
+	return differs(t, a1, x, 0);
+    default:
+	return differs(t, a1, a2, x);
+    }
+}
+
+/* 
+ * first_failure - Return index of the first of the tests (a1, a2, x[k]),
+ * k = 0..n-1, that fails, or -1 if none does.  Uses the function's
+ * batch kernel if it has one.  A mismatch found by the kernel is
+ * confirmed with a scalar call, since the two versions can disagree on
+ * code with undefined behavior, such as oversized shifts.
+ */
+static int first_failure(puzzle_t *p, int a1, int a2, const int x[], int n) {
+    int k;
+
+    if (!p->batch) {
+	for (k = 0; k < n; k++)
+	    if (differs_last(p->t, a1, a2, x[k]))
+		return k;
+	return -1;
+    }
+    for (k = 0; k < n; k++) {
+	int j = p->batch(a1, a2, x + k, n - k);
+	if (j < 0)
+	    return -1;
+	k += j;
+	if (differs_last(p->t, a1, a2, x[k]))
+	    return k;
+    }
+    return -1;
+}
+
+/* 
+ * search_wide - Like search_range, for 64-bit functions, whose values
+ * don't fit in the buffers of int, and which have no batch kernels
+ */
+static void search_wide(puzzle_t *p, long long lo, long long hi) {
+    long long stride = p->counts[1] * p->counts[2];
+    long long a1, a2, a3;
+
+    for (a1 = lo; a1 < hi; a1++) {
+	long long v1 = gen_value(&p->gens[0], a1);
+	if (a1 * stride >= __atomic_load_n(&p->fail_index, __ATOMIC_RELAXED)
+	    || __atomic_load_n(&p->timed_out, __ATOMIC_RELAXED))
+	    return;
+	for (a2 = 0; a2 < p->counts[1]; a2++) {
+	    long long v2 = gen_value(&p->gens[1], a2);
+	    for (a3 = 0; a3 < p->counts[2]; a3++)
+		if (differs(p->t, v1, v2, gen_value(&p->gens[2], a3))) {
+		    record_failure(p, a1 * stride + a2 * p->counts[2] + a3);
+		    return;
+		}
+	}
+    }
+}
+
+/* 
+ * search_range - Test function on first-argument values lo..hi-1.
+ * Stops as soon as some failing test with a lower index is known, or
+ * the function has timed out.  The values of the last argument are
+ * generated and tested in blocks, with the batch kernel.
+ */
+static void search_range(puzzle_t *p, long long lo, long long hi) {
+    long long stride = p->counts[1] * p->counts[2];
+    int last = p->t->args > 0 ? p->t->args - 1 : 0;
+    long long a1, a2, a3;
+    int x[BLOCK_SIZE];
+    int cache[CACHE_SIZE];
+    int cached = p->counts[last] <= CACHE_SIZE;
+    int k;
+
+    if (width_of(p->t) == 64) {
+	search_wide(p, lo, hi);
+	return;
+    }
+
+    /* First argument is the last one.  Test it in blocks */
+    if (last == 0) {
+	for (a1 = lo; a1 < hi; a1 += BLOCK_SIZE) {
+	    int n = hi - a1 < BLOCK_SIZE ? hi - a1 : BLOCK_SIZE;
+	    if (a1 >= __atomic_load_n(&p->fail_index, __ATOMIC_RELAXED)
+		|| __atomic_load_n(&p->timed_out, __ATOMIC_RELAXED))
+		return;
+	    gen_fill(&p->gens[0], a1, n, x);
+	    k = first_failure(p, 0, 0, x, n);
+	    if (k >= 0) {
+		record_failure(p, a1 + k);
+		return;
+	    }
+	}
+	return;
+    }
+
+    if (cached)
+	gen_fill(&p->gens[last], 0, p->counts[last], cache);
+    for (a1 = lo; a1 < hi; a1++) {
+	int v1 = gen_value(&p->gens[0], a1);
+	if (a1 * stride >= __atomic_load_n(&p->fail_index, __ATOMIC_RELAXED)
+	    || __atomic_load_n(&p->timed_out, __ATOMIC_RELAXED))
+	    return;
+	for (a2 = 0; a2 < (last == 2 ? p->counts[1] : 1); a2++) {
+	    int v2 = gen_value(&p->gens[1], a2);
+	    for (a3 = 0; a3 < p->counts[last]; a3 += BLOCK_SIZE) {
+		int n = p->counts[last] - a3 < BLOCK_SIZE ?
+		    p->counts[last] - a3 : BLOCK_SIZE;
+		int *vals = cache + a3;
+		if (!cached) {
+		    gen_fill(&p->gens[last], a3, n, x);
+		    vals = x;
+		}
+		k = first_failure(p, v1, v2, vals, n);
+		if (k >= 0) {
+		    record_failure(p, a1 * stride + a2 * p->counts[2] + a3 + k);
+		    return;
+		}
+	    }
+	}
+    }
+}
+
+/*
+ * Counterexamples are shrunk by repeatedly replacing an argument with
+ * a simpler value on which the function still fails: 0, -1, 1, TMin
+ * or TMax, the value with one bit flipped, or half the value.  A value
+ * is simpler when fewer of its bits differ from 0 or from -1, or else
+ * when it is closer to one of them.
+ */
+
+/* Shrinking stops after this many seconds, in case the function loops
+   forever on some simpler value */
+#define SHRINK_TIMEOUT 1
+
+/* Number of candidates for a simpler value of width bits */
+#define SHRINK_CANDIDATES(width) (6 + (width))
+
+/* Is a simpler than b, as values of width bits? */
+static int simpler(long long a, long long b, int width) {
+    unsigned long long mask = width_mask(width);
+    unsigned long long ua = a & mask, ub = b & mask;
+    int bits_a = __builtin_popcountll(ua), bits_b = __builtin_popcountll(ub);
+
+    if (width - bits_a < bits_a)
+	bits_a = width - bits_a;
+    if (width - bits_b < bits_b)
+	bits_b = width - bits_b;
+    if (bits_a != bits_b)
+	return bits_a < bits_b;
+    if ((~ua & mask) < ua)
+	ua = ~ua & mask;
+    if ((~ub & mask) < ub)
+	ub = ~ub & mask;
+    return ua < ub;
+}
+
+/* Candidate k for a value simpler than v, of width bits */
+static long long shrink_candidate(long long v, int k, int width) {
+    unsigned long long tmin = 1ULL << (width - 1);
 
+    switch (k) {
+    case 0: return 0;
+    case 1: return -1;
+    case 2: return 1;
+    case 3: return sext(tmin, width);
+    case 4: return sext(tmin - 1, width);
     }
+    if (k < 5 + width)
+	return sext(v ^ (1ULL << (k - 5)), width);
+    return v / 2;
+}
+
+/* 
+ * shrink - Simplify the arguments of a failing test of p
+ */
+static void shrink(puzzle_t *p, long long args[]) {
+    test_ptr t = p->t;
+    int width = width_of(t);
+    long long trial[3];
+    int i, k, changed;
+
+    if (timeout_limit > 0) {
+	/* args only ever holds failing tests, so it can be used as is
+	   after a timeout */
+	if (sigsetjmp(envbuf, 1))
+	    return;
+	alarm(SHRINK_TIMEOUT);
+    }
+    do {
+	changed = 0;
+	for (i = 0; i < t->args; i++) {
+	    if (p->gens[i].kind == GEN_FIXED || p->gens[i].kind == GEN_FLOAT)
+		continue;
+	    for (k = 0; k < SHRINK_CANDIDATES(width); k++) {
+		long long c = shrink_candidate(args[i], k, width);
+		if (c < t->arg_ranges[i][0] || c > t->arg_ranges[i][1]
+		    || !simpler(c, args[i], width))
+		    continue;
+		memcpy(trial, args, sizeof(trial));
+		trial[i] = c;
+		if (differs(t, trial[0], trial[1], trial[2])) {
+		    args[i] = c;
+		    changed = 1;
+		    break;
+		}
+	    }
+	}
+    } while (changed);
+    alarm(0);
+}
+
+/* 
+ * failing_args - Find the arguments of the first failing test of p,
+ * and shrink them
+ */
+static void failing_args(puzzle_t *p) {
+    long long index = p->fail_index;
+
+    p->fail_args[2] = gen_value(&p->gens[2], index % p->counts[2]);
+    index /= p->counts[2];
+    p->fail_args[1] = gen_value(&p->gens[1], index % p->counts[1]);
+    p->fail_args[0] = gen_value(&p->gens[0], index / p->counts[1]);
+    shrink(p, p->fail_args);
+    p->have_args = 1;
+}
+
+/* 
+ * report_test - Print the outcome of testing a function.  Return
+ * number of errors
+ */
+static int report_test(puzzle_t *p) {
+    test_ptr t = p->t;
+    long long index = p->fail_index;
+
+    if (p->timed_out) {
+	printf("ERROR: Test %s failed.\n  Timed out after %d secs (probably infinite loop)\n", t->name, p->limit);
+	return 1;
+    }
+    if (p->crashed > 0) {
+	printf("ERROR: Test %s failed.\n  Crashed with signal %d (%s)\n", t->name, p->crashed, strsignal(p->crashed));
+	return 1;
+    }
+    if (p->crashed < 0) {
+	printf("ERROR: Test %s failed.\n  Test process exited without a result\n", t->name);
+	return 1;
+    }
+    if (index == LLONG_MAX)
+	return 0;
+
+    /* Rerun the failing test to show the counterexample */
+    if (!p->have_args)
+	failing_args(p);
+    return show_test(t, p->fail_args);
+}
+
+/* 
+ * test_function - Test a function.  Return number of errors 
+ */
+static int test_function(test_ptr t) {
+    puzzle_t p;
+    int boundary = has_boundary(t);
+
+    prepare_test(&p, t, boundary);
 
     /* Handle timeouts in the test code */
     if (timeout_limit > 0) {
@@ -350,72 +1036,1196 @@ static int test_function(test_ptr t) {
 	rc = sigsetjmp(envbuf, 1);
 	if (rc) {
 	    /* control will reach here if there is a timeout */
-	    errors = 1;
-	    printf("ERROR: Test %s failed.\n  Timed out after %d secs (probably infinite loop)\n", t->name, timeout_limit);
-	    return errors;
+	    p.timed_out = 1;
+	    return report_test(&p);
 	}
-	alarm(timeout_limit);
+	alarm(p.limit);
     }
 
+    search_range(&p, 0, p.counts[0]);
+    if (boundary && p.fail_index == LLONG_MAX) {
+	/* Passed on the boundary values, so go on to the sampled ones */
+	prepare_test(&p, t, 0);
+	search_range(&p, 0, p.counts[0]);
+    }
+    alarm(0);
 
-    /* Test function has no arguments */
-    if (args == 0) {
-	errors += test_0_arg(t->solution_funct, t->test_funct, t->name);
-	return errors;
-    } 
+    return report_test(&p);
+}
 
-    /* 
-     * Test function has at least one argument 
-     */
-      
-    /* Iterate over the values for first argument */
-
-    for (a1 = 0; a1 < test_counts[0]; a1++) {
-	if (args == 1) {
-	    errors += test_1_arg(t->solution_funct, 
-				 t->test_funct,
-				 arg_test_vals[0][a1],
-				 t->name);
-
-	    /* Stop testing if there is an error */
-	    if (errors)
-		return errors;
-	} 
-	else {
-	    /* if necessary, iterate over values for second argument */
-	    for (a2 = 0; a2 < test_counts[1]; a2++) {
-		if (args == 2) {
-		    errors += test_2_arg(t->solution_funct, 
-					 t->test_funct,
-					 arg_test_vals[0][a1], 
-					 arg_test_vals[1][a2],
-					 t->name);
-
-		    /* Stop testing if there is an error */
-		    if (errors)
-			return errors;
-		} 
-		else {
-		    /* if necessary, iterate over vals for third arg */
-		    for (a3 = 0; a3 < test_counts[2]; a3++) {
-			errors += test_3_arg(t->solution_funct, 
-					     t->test_funct,
-					     arg_test_vals[0][a1], 
-					     arg_test_vals[1][a2],
-					     arg_test_vals[2][a3],
-					     t->name);
-			
-			/* Stop testing if there is an error */
-			if (errors)
-			    return errors;
-		    } /* a3 */
-		}
-	    } /* a2 */
+/*
+ * Parallel testing.  The a1 values of each function are split into
+ * chunks, and a pool of worker threads takes chunks in order of
+ * function and then a1.  The main thread watches for timeouts.
+ */
+
+/* Target number of chunks for each function */
+#define CHUNKS_PER_TEST 64
+
+/* How often the main thread checks for timeouts, in milliseconds */
+#define WATCH_INTERVAL 50
+
+typedef struct {
+    puzzle_t *p;
+    long long lo, hi;       /* Range of a1 values */
+} task_t;
+
+static task_t *tasks;
+static int ntasks;
+static int next_task = 0;
+
+/* Each worker slot records the task it is running.  When a function
+   times out, its workers are abandoned (they may never return), and
+   their slots are given to fresh threads */
+typedef struct {
+    int task;               /* Task being run, -1 when between tasks */
+    int generation;         /* Incremented when slot is reassigned */
+} worker_t;
+
+static worker_t *workers;
+static pthread_mutex_t task_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t task_done = PTHREAD_COND_INITIALIZER;
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1.0E-9 * ts.tv_nsec;
+}
+
+static void *run_worker(void *arg) {
+    int slot = (int) (long) arg;
+    int generation;
+
+    pthread_mutex_lock(&task_lock);
+    generation = workers[slot].generation;
+    while (next_task < ntasks) {
+	int i = next_task++;
+	task_t *tp = &tasks[i];
+	if (tp->p->start == 0)
+	    tp->p->start = now();
+	workers[slot].task = i;
+	pthread_mutex_unlock(&task_lock);
+
+	search_range(tp->p, tp->lo, tp->hi);
+
+	pthread_mutex_lock(&task_lock);
+	if (workers[slot].generation != generation)
+	    /* Abandoned while running a function that timed out */
+	    break;
+	workers[slot].task = -1;
+	tp->p->chunks_done++;
+	pthread_cond_signal(&task_done);
+    }
+    pthread_mutex_unlock(&task_lock);
+    return NULL;
+}
+
+static void start_worker(int slot) {
+    pthread_t tid;
+    sigset_t mask, old_mask;
+
+    /* Workers inherit a mask that blocks SIGALRM, so that it always
+       goes to the main thread when it shrinks counterexamples */
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &mask, &old_mask);
+    workers[slot].task = -1;
+    if (pthread_create(&tid, NULL, run_worker, (void *) (long) slot) != 0) {
+	printf("Couldn't create worker thread\n");
+	exit(1);
+    }
+    pthread_detach(tid);
+    pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+}
+
+/*
+ * make_tasks - Split each of functions puzzles[0..n-1] into at most
+ * chunks tasks, by a1 value
+ */
+static void make_tasks(puzzle_t *puzzles, int n, int chunks) {
+    int i;
+    long long j;
+
+    tasks = malloc(n * chunks * sizeof(task_t));
+    if (!tasks) {
+	printf("Couldn't allocate space for tasks\n");
+	exit(1);
+    }
+    ntasks = 0;
+    for (i = 0; i < n; i++) {
+	puzzle_t *p = &puzzles[i];
+	long long size = (p->counts[0] + chunks - 1) / chunks;
+	for (j = 0; j < p->counts[0]; j += size) {
+	    tasks[ntasks].p = p;
+	    tasks[ntasks].lo = j;
+	    tasks[ntasks].hi = j + size < p->counts[0] ? j + size : p->counts[0];
+	    ntasks++;
+	    p->nchunks++;
 	}
-    } /* a1 */
+    }
+}
 
-    
-    return errors;
+/*
+ * test_parallel - Test functions puzzles[0..n-1] with the worker pool
+ */
+static void test_parallel(puzzle_t *puzzles, int n) {
+    int i;
+
+    make_tasks(puzzles, n, CHUNKS_PER_TEST);
+    workers = calloc(nthreads, sizeof(worker_t));
+    if (!workers) {
+	printf("Couldn't allocate space for worker pool\n");
+	exit(1);
+    }
+
+    pthread_mutex_lock(&task_lock);
+    for (i = 0; i < nthreads; i++)
+	start_worker(i);
+
+    /* Wait until every function has either completed or timed out */
+    for (;;) {
+	int finished = 1;
+	for (i = 0; i < n; i++)
+	    if (!puzzles[i].timed_out
+		&& puzzles[i].chunks_done < puzzles[i].nchunks)
+		finished = 0;
+	if (finished)
+	    break;
+
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_nsec += WATCH_INTERVAL * 1000000L;
+	if (ts.tv_nsec >= 1000000000L) {
+	    ts.tv_sec++;
+	    ts.tv_nsec -= 1000000000L;
+	}
+	pthread_cond_timedwait(&task_done, &task_lock, &ts);
+
+	if (timeout_limit <= 0)
+	    continue;
+	double t = now();
+	for (i = 0; i < nthreads; i++) {
+	    int k = workers[i].task;
+	    if (k < 0)
+		continue;
+	    puzzle_t *p = tasks[k].p;
+	    if (!p->timed_out && t - p->start < p->limit)
+		continue;
+	    /* Stop remaining work on the function, and replace the
+	       thread, since it might never finish */
+	    __atomic_store_n(&p->timed_out, 1, __ATOMIC_RELAXED);
+	    workers[i].generation++;
+	    start_worker(i);
+	}
+    }
+    pthread_mutex_unlock(&task_lock);
+    /* Abandoned threads are left running until the program exits */
+}
+
+/**********
+ * Fuzzing
+ **********/
+
+/*
+ * Fuzzing (-Z) looks for a failing test by mutating the arguments of
+ * earlier tests, with bit flips, small additions, and values from the
+ * boundary set or seen while running the code, rather than by working
+ * through a fixed list.  Puzzle
+ * solutions have no branches, so the code they cover can't tell which
+ * arguments are interesting.  Instead, the solution and its reference
+ * function are also run through the bvexpr evaluator, which reports
+ * the value of every expression in them, and arguments that give some
+ * expression a new kind of value (a new sign, highest significant bit,
+ * or number of set bits) are kept for further mutation.  Each function
+ * is fuzzed in its own child process, as with -F, which also keeps the
+ * evaluator, which isn't thread safe, to one thread.
+ */
+
+/* Most arguments kept for mutation */
+#define FUZZ_CORPUS 4096
+
+/* Kinds of values are hashed into a table of this many bits */
+#define FUZZ_FEATURES (1 << 16)
+
+/* The evaluator is hundreds of times slower than the compiled code,
+   so only one mutant in this many is run through it */
+#define FUZZ_EVAL_RATE 16
+
+/* Mutants tested between checks of the clock */
+#define FUZZ_BATCH 1024
+
+/* Most values seen in the evaluator that are kept for mutation */
+#define FUZZ_DICT 1024
+
+/* Fuzz each function for this many seconds (-Z) */
+static int fuzz_time = 0;
+
+typedef struct {
+    long long args[3];
+} fuzz_input_t;
+
+static fuzz_input_t *corpus;
+static int corpus_size;
+static unsigned char fuzz_seen[FUZZ_FEATURES / 8];
+static int fuzz_new;            /* New kinds of values in latest run */
+static int fuzz_features;       /* Kinds of values seen */
+static long long fuzz_dict[FUZZ_DICT];
+static int dict_size;
+static unsigned fuzz_state;     /* Random number generator state */
+
+static unsigned fuzz_rand() {
+    fuzz_state ^= fuzz_state << 13;
+    fuzz_state ^= fuzz_state >> 17;
+    fuzz_state ^= fuzz_state << 5;
+    return fuzz_state;
+}
+
+static void fuzz_feature(int site, int kind, int bucket) {
+    unsigned f = ((site * 4u + kind) * 128u + bucket) * 2654435761u >> 16;
+    if (!(fuzz_seen[f / 8] & (1 << (f % 8)))) {
+	fuzz_seen[f / 8] |= 1 << (f % 8);
+	fuzz_new++;
+	fuzz_features++;
+    }
+}
+
+/* Record the kind of value v of expression site */
+static void fuzz_observe(int site, bv_t *v) {
+    int width = v->type.width < 64 ? v->type.width : 64;
+    unsigned long long u = 0, m;
+    long long s;
+    int i, seen = fuzz_features;
+
+    for (i = 0; i < width; i++)
+	if (v->bits[i])
+	    u |= 1ULL << i;
+    s = sext(u, width);
+    fuzz_feature(site, 0, s == 0 ? 0 : s == -1 ? 1 : s < 0 ? 2 : 3);
+    /* Highest bit that differs from the sign */
+    m = s < 0 ? ~s : s;
+    fuzz_feature(site, 1, m ? 64 - __builtin_clzll(m) : 0);
+    fuzz_feature(site, 2, __builtin_popcountll(u));
+    /* Values of a new kind, such as the constants in the code, are
+       good candidates for arguments */
+    if (fuzz_features > seen && dict_size < FUZZ_DICT)
+	fuzz_dict[dict_size++] = s;
+}
+
+/* Concrete bits, for running functions in the evaluator */
+static int bit_not(int a) { return !a; }
+static int bit_and(int a, int b) { return a & b; }
+static int bit_or(int a, int b) { return a | b; }
+static int bit_xor(int a, int b) { return a ^ b; }
+static int bit_ite(int i, int t, int e) { return i ? t : e; }
+
+static bit_ops_t fuzz_ops = {
+    0, 1, bit_not, bit_and, bit_or, bit_xor, bit_ite, fuzz_observe
+};
+
+/* Run function f in the evaluator on args */
+static void fuzz_eval(func_ptr f, int nargs, long long args[]) {
+    bv_t a[3], r;
+    int i;
+
+    if (!f)
+	return;
+    for (i = 0; i < nargs; i++)
+	bv_const(&fuzz_ops, bv_func_param_type(f, i), args[i], &a[i]);
+    bv_eval_func(f, a, &fuzz_ops, &r);
+}
+
+/* Mutate v, a value of width bits */
+static long long fuzz_mutate_val(long long v, int width) {
+    unsigned long long u = v;
+    boundary_t *b;
+
+    switch (fuzz_rand() % 8) {
+    case 0:
+	u ^= 1ULL << fuzz_rand() % width;
+	break;
+    case 1:
+	u ^= 3ULL << fuzz_rand() % (width - 1);
+	break;
+    case 2:
+	u += 1 + fuzz_rand() % 35;
+	break;
+    case 3:
+	u -= 1 + fuzz_rand() % 35;
+	break;
+    case 4:
+	b = get_boundary(width);
+	if (dict_size > 0 && fuzz_rand() % 2)
+	    u = fuzz_dict[fuzz_rand() % dict_size];
+	else
+	    u = b->vals[fuzz_rand() % b->n];
+	break;
+    case 5:
+	u = -u;
+	break;
+    case 6:
+	u = ~u;
+	break;
+    default:
+	u ^= (unsigned long long) (fuzz_rand() & 0xff)
+	    << 8 * (fuzz_rand() % (width / 8));
+	break;
+    }
+    return sext(u, width);
+}
+
+/* Bring argument i of test t into its range.  Floating point arguments
+   take any value */
+static long long fuzz_clamp(test_ptr t, int i, long long v) {
+    long long min = t->arg_ranges[i][0], max = t->arg_ranges[i][1];
+    int width = width_of(t);
+
+    if (has_arg[i])
+	return sext(argval[i], width);
+    if ((min == 1 && max == 1) || (v >= min && v <= max))
+	return v;
+    return min + (long long) ((v & width_mask(width))
+			      % ((unsigned long long) max - min + 1));
+}
+
+static void fuzz_mutate(test_ptr t, fuzz_input_t *in) {
+    int n = 1 + fuzz_rand() % 2;
+    int width = width_of(t);
+    int i, j;
+
+    while (n-- > 0) {
+	i = fuzz_rand() % t->args;
+	j = fuzz_rand() % t->args;
+	/* Sometimes make arguments equal or adjacent */
+	if (i != j && fuzz_rand() % 8 == 0)
+	    in->args[i] = sext(in->args[j] + (int) (fuzz_rand() % 3) - 1,
+			       width);
+	else
+	    in->args[i] = fuzz_mutate_val(in->args[i], width);
+    }
+    for (i = 0; i < t->args; i++)
+	in->args[i] = fuzz_clamp(t, i, in->args[i]);
+}
+
+/* Test input, and keep it if it is new.  Return 1 if it fails */
+static int fuzz_try(puzzle_t *p, func_ptr f, func_ptr ft, fuzz_input_t *in,
+		    int eval) {
+    test_ptr t = p->t;
+
+    p->fuzz_runs++;
+    if (differs(t, in->args[0], in->args[1], in->args[2])) {
+	memcpy(p->fail_args, in->args, sizeof(p->fail_args));
+	shrink(p, p->fail_args);
+	p->have_args = 1;
+	p->fail_index = 0;
+	return 1;
+    }
+    if (!eval)
+	return 0;
+    fuzz_new = 0;
+    fuzz_eval(f, t->args, in->args);
+    fuzz_eval(ft, t->args, in->args);
+    if (fuzz_new > 0) {
+	if (corpus_size < FUZZ_CORPUS)
+	    corpus[corpus_size++] = *in;
+	else
+	    corpus[fuzz_rand() % FUZZ_CORPUS] = *in;
+	p->fuzz_kept = corpus_size;
+	p->fuzz_features = fuzz_features;
+    }
+    return 0;
+}
+
+/*
+ * fuzz - Fuzz function p for fuzz_time seconds, or until it fails.
+ * Runs in a child process
+ */
+static void fuzz(puzzle_t *p) {
+    test_ptr t = p->t;
+    char tname[256];
+    func_ptr f = NULL, ft = NULL;
+    double end = now() + fuzz_time;
+    fuzz_input_t in;
+    boundary_t *b = get_boundary(width_of(t));
+    int i, k;
+
+    corpus = malloc(FUZZ_CORPUS * sizeof(fuzz_input_t));
+    if (!corpus) {
+	printf("Couldn't allocate space for fuzzing\n");
+	exit(1);
+    }
+    fuzz_state = mix64(test_seed) + 2463534242u + (t - test_set);
+    if (fuzz_state == 0)
+	fuzz_state = 2463534242u;
+    if (t->args == 0) {
+	in.args[0] = in.args[1] = in.args[2] = 0;
+	fuzz_try(p, NULL, NULL, &in, 0);
+	return;
+    }
+
+    /* Without the source, fuzzing still runs, but unguided */
+    snprintf(tname, sizeof(tname), "test_%s", t->name);
+    if (bv_parse_file("bits.c") && bv_parse_file("tests.c")) {
+	f = bv_find_func(t->name);
+	ft = bv_find_func(tname);
+	if (f && (bv_func_error(f) || bv_func_nparams(f) != t->args))
+	    f = NULL;
+	if (ft && (bv_func_error(ft) || bv_func_nparams(ft) != t->args))
+	    ft = NULL;
+    }
+
+    /* Start from the simplest boundary values */
+    memset(&in, 0, sizeof(in));
+    for (k = 0; k < 7; k++) {
+	for (i = 0; i < t->args; i++)
+	    in.args[i] = fuzz_clamp(t, i, b->vals[k]);
+	if (fuzz_try(p, f, ft, &in, 1))
+	    return;
+	if (corpus_size == 0)
+	    corpus[corpus_size++] = in;
+    }
+    while (now() < end)
+	for (k = 0; k < FUZZ_BATCH; k++) {
+	    in = corpus[fuzz_rand() % corpus_size];
+	    fuzz_mutate(t, &in);
+	    if (fuzz_try(p, f, ft, &in, k % FUZZ_EVAL_RATE == 0))
+		return;
+	}
+}
+
+/*
+ * Forked testing (-F).  Each function is split into one chunk of a1
+ * values per process, and each chunk is tested in a child process,
+ * with up to nthreads children running at once.  The timeout limit
+ * becomes a limit on the child's CPU time, enforced by the kernel, so
+ * a function that crashes or loops forever takes down only its own
+ * child.  The child sends back the index of its first failing test,
+ * or LLONG_MAX, over a pipe, along with the shrunk arguments of the
+ * test.
+ */
+
+typedef struct {
+    long long index;
+    long long args[3];
+    long long fuzz_runs;
+    int fuzz_kept, fuzz_features;
+} child_result_t;
+
+typedef struct {
+    pid_t pid;              /* 0 when the slot is free */
+    int fd;                 /* Read end of the child's pipe */
+    puzzle_t *p;
+} child_t;
+
+static void start_child(child_t *c, puzzle_t *p, long long lo, long long hi) {
+    int fds[2];
+
+    /* Keep the child from flushing a copy of buffered output */
+    fflush(stdout);
+    if (pipe(fds) < 0 || (c->pid = fork()) < 0) {
+	printf("Couldn't start test process\n");
+	exit(1);
+    }
+    if (c->pid == 0) {
+	struct rlimit rl;
+	child_result_t r;
+	close(fds[0]);
+	rl.rlim_cur = p->limit + fuzz_time;
+	rl.rlim_max = rl.rlim_cur + SHRINK_TIMEOUT + 1;
+	if (p->limit > 0)
+	    setrlimit(RLIMIT_CPU, &rl);
+	if (fuzz_time > 0)
+	    fuzz(p);
+	else
+	    search_range(p, lo, hi);
+	if (p->fail_index != LLONG_MAX && !p->have_args) {
+	    /* Shrink here, where a crash can't hurt, with time to spare */
+	    rl.rlim_cur = rl.rlim_max;
+	    if (p->limit > 0)
+		setrlimit(RLIMIT_CPU, &rl);
+	    failing_args(p);
+	}
+	r.index = p->fail_index;
+	memcpy(r.args, p->fail_args, sizeof(r.args));
+	r.fuzz_runs = p->fuzz_runs;
+	r.fuzz_kept = p->fuzz_kept;
+	r.fuzz_features = p->fuzz_features;
+	if (write(fds[1], &r, sizeof(r)) != sizeof(r))
+	    _exit(1);
+	_exit(0);
+    }
+    close(fds[1]);
+    c->fd = fds[0];
+    c->p = p;
+}
+
+/* Record the result of child c, which exited with status */
+static void finish_child(child_t *c, int status) {
+    puzzle_t *p = c->p;
+    child_result_t r;
+
+    if (WIFSIGNALED(status)) {
+	/* SIGXCPU is sent at the CPU limit, and SIGKILL a second later */
+	if (WTERMSIG(status) == SIGXCPU || WTERMSIG(status) == SIGKILL)
+	    p->timed_out = 1;
+	else if (!p->crashed)
+	    p->crashed = WTERMSIG(status);
+    } else if (read(c->fd, &r, sizeof(r)) == sizeof(r)) {
+	p->fuzz_runs += r.fuzz_runs;
+	p->fuzz_kept += r.fuzz_kept;
+	p->fuzz_features += r.fuzz_features;
+	if (r.index < p->fail_index) {
+	    p->fail_index = r.index;
+	    memcpy(p->fail_args, r.args, sizeof(r.args));
+	    p->have_args = r.index != LLONG_MAX;
+	}
+    } else if (!p->crashed)
+	p->crashed = -1;
+    close(c->fd);
+    c->pid = 0;
+}
+
+/*
+ * test_forked - Test functions puzzles[0..n-1] in child processes
+ */
+static void test_forked(puzzle_t *puzzles, int n) {
+    child_t *children = calloc(nthreads, sizeof(child_t));
+    int next = 0, running = 0;
+    int k, status;
+    pid_t pid;
+
+    if (!children) {
+	printf("Couldn't allocate space for test processes\n");
+	exit(1);
+    }
+    /* A function is fuzzed in a single process */
+    make_tasks(puzzles, n, fuzz_time > 0 ? 1 : nthreads);
+    while (next < ntasks || running > 0) {
+	if (next < ntasks && running < nthreads) {
+	    task_t *tp = &tasks[next++];
+	    puzzle_t *p = tp->p;
+	    /* Skip chunks that can't change the outcome */
+	    if (p->timed_out || p->crashed
+		|| tp->lo * p->counts[1] * p->counts[2] >= p->fail_index)
+		continue;
+	    for (k = 0; children[k].pid; k++)
+		;
+	    start_child(&children[k], p, tp->lo, tp->hi);
+	    running++;
+	    continue;
+	}
+	pid = wait(&status);
+	if (pid < 0) {
+	    printf("Lost track of test processes\n");
+	    exit(1);
+	}
+	for (k = 0; k < nthreads; k++)
+	    if (children[k].pid == pid) {
+		finish_child(&children[k], status);
+		running--;
+	    }
+    }
+    free(children);
+}
+
+/**************
+ * Benchmarking
+ **************/
+
+/* Calls in each timed pass over the argument stream */
+#define BENCH_VALS 4096
+
+/* Passes timed for each measurement, keeping the fastest */
+#define BENCH_REPS 20
+
+/*
+ * Time is measured with the processor's time stamp counter where
+ * there is one.  On recent x86 processors it counts at a fixed
+ * reference rate, which matches the core clock unless frequency
+ * scaling is active
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#define BENCH_UNIT "cycles"
+static unsigned long long ticks() {
+    return __rdtsc();
+}
+#else
+#define BENCH_UNIT "ns"
+static unsigned long long ticks() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+#endif
+
+/* Fixed stream of arguments */
+static long long bench_args[3][BENCH_VALS];
+
+/* Always zero, but unknown to the compiler, so that it can't break
+   dependency chains */
+static volatile int bench_zero = 0;
+
+/* Results are accumulated here, so that calls aren't optimized away */
+static volatile long long bench_sink;
+
+/* Function that does no work, showing the cost of a call */
+static int bench_nop(int x) { return x; }
+
+/*
+ * bench_pass - Call f on the argument stream.  With chain set, each
+ * result feeds into the first argument of the next call, so that the
+ * time per call is its latency.  Otherwise, the calls are independent
+ * and can overlap, giving the throughput.  f is a 64-bit function if
+ * wide is set.  Return elapsed ticks
+ */
+static unsigned long long bench_pass(funct_t f, int args, int wide,
+				     int chain) {
+    long long *a1 = bench_args[0], *a2 = bench_args[1], *a3 = bench_args[2];
+    int zero = bench_zero;
+    long long r = 0;
+    int k;
+    unsigned long long start = ticks();
+
+    switch (wide ? args + 3 : args) {
+    case 1: {
+	funct1_t f1 = (funct1_t) f;
+	if (chain)
+	    for (k = 0; k < BENCH_VALS; k++)
+		r = f1(a1[k] ^ (r & zero));
+	else
+	    for (k = 0; k < BENCH_VALS; k++)
+		r += f1(a1[k]);
+	break;
+    }
+    case 2: {
+	funct2_t f2 = (funct2_t) f;
+	if (chain)
+	    for (k = 0; k < BENCH_VALS; k++)
+		r = f2(a1[k] ^ (r & zero), a2[k]);
+	else
+	    for (k = 0; k < BENCH_VALS; k++)
+		r += f2(a1[k], a2[k]);
+	break;
+    }
+    case 3: {
+	funct3_t f3 = (funct3_t) f;
+	if (chain)
+	    for (k = 0; k < BENCH_VALS; k++)
+		r = f3(a1[k] ^ (r & zero), a2[k], a3[k]);
+	else
+	    for (k = 0; k < BENCH_VALS; k++)
+		r += f3(a1[k], a2[k], a3[k]);
+	break;
+    }
+    case 4: {
+	lfunct1_t f1 = (lfunct1_t) f;
+	if (chain)
+	    for (k = 0; k < BENCH_VALS; k++)
+		r = f1(a1[k] ^ (r & zero));
+	else
+	    for (k = 0; k < BENCH_VALS; k++)
+		r += f1(a1[k]);
+	break;
+    }
+    case 5: {
+	lfunct2_t f2 = (lfunct2_t) f;
+	if (chain)
+	    for (k = 0; k < BENCH_VALS; k++)
+		r = f2(a1[k] ^ (r & zero), a2[k]);
+	else
+	    for (k = 0; k < BENCH_VALS; k++)
+		r += f2(a1[k], a2[k]);
+	break;
+    }
+    default: {
+	lfunct3_t f3 = (lfunct3_t) f;
+	if (chain)
+	    for (k = 0; k < BENCH_VALS; k++)
+		r = f3(a1[k] ^ (r & zero), a2[k], a3[k]);
+	else
+	    for (k = 0; k < BENCH_VALS; k++)
+		r += f3(a1[k], a2[k], a3[k]);
+	break;
+    }
+    }
+    bench_sink = r;
+    return ticks() - start;
+}
+
+/*
+ * bench_time - Time per call of f, after a warm-up pass.  Times
+ * include the cost of the call itself
+ */
+static double bench_time(funct_t f, int args, int wide, int chain) {
+    unsigned long long best = ~0ULL;
+    int i;
+
+    bench_pass(f, args, wide, chain);
+    for (i = 0; i < BENCH_REPS; i++) {
+	unsigned long long t = bench_pass(f, args, wide, chain);
+	if (t < best)
+	    best = t;
+    }
+    return (double) best / BENCH_VALS;
+}
+
+/****************
+ * Coding rules
+ ****************/
+
+/* Functions that break the coding rules fail without being tested
+   (-c), and so do those with too many operators (-C).  Holds the
+   rules_check flags that say which functions are zapped */
+static int rule_flags = 0;
+
+/* Grade everything in one run, and print the results as JSON (-G) */
+static int json = 0;
+
+/* Performance points for a puzzle, given when it is correct and within
+   its operator limit */
+#define PERF_RATING 2
+
+/*
+ * check_rules - Check the functions in bits.c against the coding
+ * rules, as dlcheck does, reporting problems to out unless it is NULL.
+ * Store the results for test_set[i] in r[i], with r[i].name NULL for
+ * functions that aren't defined.  Return 0 if bits.c can't be read
+ */
+static int check_rules(rule_result_t r[], FILE *out) {
+    rule_t rules[256];
+    rule_result_t *results;
+    char *text;
+    int i, k, n;
+
+    for (i = 0; test_set[i].solution_funct; i++) {
+	rules[i].name = test_set[i].name;
+	rules[i].ops = test_set[i].ops;
+	rules[i].max_ops = test_set[i].op_limit;
+	r[i].name = NULL;
+    }
+    rules[i].name = NULL;
+    text = rules_read_file("bits.c");
+    if (!text)
+	return 0;
+    n = rules_check(text, "bits.c", rules, 0, out, &results);
+    free(text);
+    if (n < 0)
+	return 0;
+    for (k = 0; k < n; k++)
+	for (i = 0; test_set[i].solution_funct; i++)
+	    if (strcmp(test_set[i].name, results[k].name) == 0)
+		r[i] = results[k];
+    free(results);
+    return 1;
+}
+
+/*
+ * get_op_counts - Get the operator count of each function, as used
+ * for the performance score.  Counts are -1 if bits.c can't be read
+ */
+static void get_op_counts(int counts[]) {
+    rule_result_t r[256];
+    int i, ok = check_rules(r, NULL);
+
+    for (i = 0; test_set[i].solution_funct; i++)
+	counts[i] = ok && r[i].name ? r[i].ops : -1;
+}
+
+/*
+ * bench_float - Return the bit pattern of float argument k for the
+ * benchmarks.  Most come from the windows that the tests use, around
+ * zero, the smallest normalized number, one and the largest
+ * normalized number, and one in eight is an infinity or a NaN, so
+ * that every case of a solution is timed
+ */
+static unsigned bench_float(int arg, int k)
+{
+    gen_t g;
+    long long normal = (long long) FLOAT_GROUP * (1 << 23);
+
+    g.kind = GEN_FLOAT;
+    g.range = 1 << 23;
+    if (random_val(0, 7, arg + 3, k) == 0)
+	return float_value(&g, normal + random_val(0, 3, arg, k));
+    return float_value(&g, random_val(0, normal - 1, arg, k));
+}
+
+/*
+ * run_benchmarks - Measure latency and throughput of each solution
+ * and its reference function, on a fixed stream of arguments within
+ * the test ranges, or of float bit patterns for float arguments
+ */
+static void run_benchmarks()
+{
+    int counts[256];
+    int i, j, k;
+
+    get_op_counts(counts);
+    printf("Time per call in %s, for solution and reference (Ref)\n",
+	   BENCH_UNIT);
+    printf("Ops\tLatency\tThruput\tRefLat\tRefThru\tFunction\n");
+    for (k = 0; k < BENCH_VALS; k++)
+	bench_args[0][k] = k;
+    printf("-\t%.1f\t%.1f\t-\t-\t(empty function)\n",
+	   bench_time((funct_t) bench_nop, 1, 0, 1),
+	   bench_time((funct_t) bench_nop, 1, 0, 0));
+    for (i = 0; test_set[i].solution_funct; i++) {
+	test_ptr t = &test_set[i];
+	int wide = width_of(t) == 64;
+	if (test_fname && strcmp(t->name, test_fname) != 0)
+	    continue;
+	if (t->args < 1 || t->args > 3) {
+	    printf("Configuration error: invalid number of args (%d) for function %s\n", t->args, t->name);
+	    exit(1);
+	}
+	/* Same arguments for every run */
+	for (j = 0; j < t->args; j++)
+	    for (k = 0; k < BENCH_VALS; k++)
+		if (t->arg_ranges[j][0] == 1 && t->arg_ranges[j][1] == 1)
+		    bench_args[j][k] = (int) bench_float(j, k);
+		else
+		    bench_args[j][k] = random_val(t->arg_ranges[j][0],
+						  t->arg_ranges[j][1], j, k);
+	if (counts[i] >= 0)
+	    printf("%d", counts[i]);
+	else
+	    printf("-");
+	printf("\t%.1f\t%.1f\t%.1f\t%.1f\t%s\n",
+	       bench_time(t->solution_funct, t->args, wide, 1),
+	       bench_time(t->solution_funct, t->args, wide, 0),
+	       bench_time(t->test_funct, t->args, wide, 1),
+	       bench_time(t->test_funct, t->args, wide, 0),
+	       t->name);
+    }
+}
+
+/****************
+ * Result cache
+ ****************/
+
+/*
+ * Functions that pass are recorded in a cache file, under a hash of
+ * their source, the source of their reference functions, and the test
+ * configuration.  A function whose hash is in the file is not tested
+ * again.  Comments and spacing are left out of the hash, and so is
+ * the source of other functions, but anything else outside the
+ * functions, such as a macro, is part of every hash.
+ */
+
+#define CACHE_FILE ".btest-cache"
+
+/* Change when the testing changes, so that old results are retested */
+#define CACHE_VERSION 3
+
+/* Most functions recorded in the cache */
+#define CACHE_ENTRIES 256
+
+/* Use the cache.  Cleared when grading, when testing particular
+   arguments, and by -R */
+static int use_cache = 1;
+
+typedef struct {
+    char name[64];
+    unsigned long long hash;
+} cache_entry_t;
+
+static cache_entry_t cache[CACHE_ENTRIES];
+static int cache_count = 0;
+
+/* Sources of the solutions and reference functions */
+static char *bits_text, *tests_text;
+
+static unsigned long long hash_bytes(unsigned long long h, const char *s,
+				     size_t n) {
+    size_t i;
+    for (i = 0; i < n; i++)
+	h = (h ^ (unsigned char) s[i]) * 0x100000001b3ULL;
+    return h;
+}
+
+/* Length of the string or character literal at s */
+static size_t literal_len(const char *s) {
+    size_t i = 1;
+    while (s[i] && s[i] != s[0])
+	i += s[i] == '\\' && s[i+1] ? 2 : 1;
+    return s[i] ? i + 1 : i;
+}
+
+/*
+ * read_source - Read C file, without comments, and with each run of
+ * white space replaced by a single space.  Return NULL if it can't be
+ * read
+ */
+static char *read_source(char *fname) {
+    FILE *fp = fopen(fname, "r");
+    char *text, *out;
+    size_t i, j, n, len = 0;
+
+    if (!fp)
+	return NULL;
+    text = malloc(1 << 20);
+    if (!text) {
+	fclose(fp);
+	return NULL;
+    }
+    len = fread(text, 1, (1 << 20) - 1, fp);
+    fclose(fp);
+    text[len] = '\0';
+
+    for (i = j = 0, out = text; i < len; ) {
+	if (text[i] == '/' && text[i+1] == '*') {
+	    char *end = strstr(text + i + 2, "*/");
+	    i = end ? end - text + 2 : len;
+	    out[j++] = ' ';
+	} else if (text[i] == '/' && text[i+1] == '/') {
+	    while (i < len && text[i] != '\n')
+		i++;
+	} else if (text[i] == '"' || text[i] == '\'') {
+	    n = literal_len(text + i);
+	    memmove(out + j, text + i, n);
+	    i += n;
+	    j += n;
+	} else if (text[i] == ' ' || text[i] == '\t' || text[i] == '\r'
+		   || text[i] == '\n') {
+	    i++;
+	    out[j++] = ' ';
+	} else
+	    out[j++] = text[i++];
+	if (j > 1 && out[j-1] == ' ' && out[j-2] == ' ')
+	    j--;
+    }
+    out[j] = '\0';
+    return out;
+}
+
+/*
+ * next_def - Find the first function definition in s at or after
+ * pos.  Set *start and *end to the ends of the definition, from the
+ * function's name to its closing brace, and *name to the name.
+ * Return 0 if there is none
+ */
+static int next_def(const char *s, size_t pos, size_t *start, size_t *end,
+		    size_t *name_len) {
+    int depth = 0;
+    size_t i, j;
+
+    for (i = pos; s[i]; i++) {
+	if (s[i] == '"' || s[i] == '\'') {
+	    i += literal_len(s + i) - 1;
+	    continue;
+	}
+	if (s[i] == '}')
+	    depth--;
+	if (s[i] != '{' || depth++ != 0)
+	    continue;
+	/* A definition has a parameter list just before its body */
+	j = i;
+	while (j > pos && s[j-1] == ' ')
+	    j--;
+	if (j == pos || s[j-1] != ')')
+	    continue;
+	for (depth = 0, j--; j > pos; j--) {
+	    depth += (s[j] == ')') - (s[j] == '(');
+	    if (depth == 0)
+		break;
+	}
+	while (j > pos && s[j-1] == ' ')
+	    j--;
+	*name_len = 0;
+	while (j > pos && (isalnum((unsigned char) s[j-1]) || s[j-1] == '_')) {
+	    j--;
+	    (*name_len)++;
+	}
+	*start = j;
+	/* Skip the body */
+	for (depth = 0; s[i]; i++) {
+	    if (s[i] == '"' || s[i] == '\'') {
+		i += literal_len(s + i) - 1;
+		continue;
+	    }
+	    depth += (s[i] == '{') - (s[i] == '}');
+	    if (depth == 0)
+		break;
+	}
+	*end = s[i] ? i + 1 : i;
+	return 1;
+    }
+    return 0;
+}
+
+/*
+ * hash_source - Mix into h the definition of function name in s, and
+ * everything in s outside of function definitions.  Return 0 if the
+ * function isn't defined there
+ */
+static int hash_source(unsigned long long *h, char *s, char *name) {
+    size_t pos = 0, start, end, name_len;
+    int found = 0;
+
+    while (next_def(s, pos, &start, &end, &name_len)) {
+	*h = hash_bytes(*h, s + pos, start - pos);
+	if (name_len == strlen(name) && strncmp(s + start, name, name_len) == 0) {
+	    *h = hash_bytes(*h, s + start, end - start);
+	    found = 1;
+	}
+	pos = end;
+    }
+    *h = hash_bytes(*h, s + pos, strlen(s + pos));
+    return found;
+}
+
+/*
+ * cache_key - Hash of function t and how it is tested.  Return 0 if
+ * its source can't be found
+ */
+static int cache_key(test_ptr t, unsigned long long *h) {
+    char tname[256];
+    int config[5];
+
+    config[0] = CACHE_VERSION;
+    config[1] = TEST_RANGE;
+    config[2] = exhaustive;
+    config[3] = t->args;
+    config[4] = width_of(t);
+    *h = 0xcbf29ce484222325ULL;
+    *h = hash_bytes(*h, (char *) config, sizeof(config));
+    *h = hash_bytes(*h, (char *) t->arg_ranges, sizeof(t->arg_ranges));
+    snprintf(tname, sizeof(tname), "test_%s", t->name);
+    return hash_source(h, bits_text, t->name) && hash_source(h, tests_text, tname);
+}
+
+/*
+ * load_cache - Read the cache file.  The cache isn't used if bits.c
+ * has changed since btest was built, since btest would be testing the
+ * old code.  The program is found through /proc/self/exe, since cmd,
+ * from argv[0], may not be its path when btest is run through PATH
+ */
+static void load_cache(char *cmd) {
+    struct stat bits_st, cmd_st;
+    char line[256];
+    FILE *fp;
+
+    if (stat("bits.c", &bits_st) < 0) {
+	use_cache = 0;
+	return;
+    }
+    if (stat("/proc/self/exe", &cmd_st) < 0 && stat(cmd, &cmd_st) < 0) {
+	if (!grade)
+	    printf("Note: Couldn't find when %s was built, so all functions are tested\n", cmd);
+	use_cache = 0;
+	return;
+    }
+    if (bits_st.st_mtim.tv_sec > cmd_st.st_mtim.tv_sec
+	|| (bits_st.st_mtim.tv_sec == cmd_st.st_mtim.tv_sec
+	    && bits_st.st_mtim.tv_nsec > cmd_st.st_mtim.tv_nsec)) {
+	if (!grade)
+	    printf("Note: bits.c is newer than %s, so all functions are tested.  Run make first\n", cmd);
+	use_cache = 0;
+	return;
+    }
+    bits_text = read_source("bits.c");
+    tests_text = read_source("tests.c");
+    if (!bits_text || !tests_text) {
+	use_cache = 0;
+	return;
+    }
+    fp = fopen(CACHE_FILE, "r");
+    if (!fp)
+	return;
+    while (cache_count < CACHE_ENTRIES && fgets(line, sizeof(line), fp)) {
+	cache_entry_t *e = &cache[cache_count];
+	if (sscanf(line, "%llx %63s", &e->hash, e->name) == 2)
+	    cache_count++;
+    }
+    fclose(fp);
+}
+
+/* Has function t passed before? */
+static int in_cache(test_ptr t) {
+    unsigned long long h;
+    int i;
+
+    if (!use_cache || !cache_key(t, &h))
+	return 0;
+    for (i = 0; i < cache_count; i++)
+	if (strcmp(cache[i].name, t->name) == 0)
+	    return cache[i].hash == h;
+    return 0;
+}
+
+/* Record whether function t passed */
+static void update_cache(test_ptr t, int passed) {
+    unsigned long long h;
+    int i;
+
+    if (!use_cache)
+	return;
+    for (i = 0; i < cache_count; i++)
+	if (strcmp(cache[i].name, t->name) == 0)
+	    break;
+    if (passed && cache_key(t, &h)) {
+	if (i == cache_count) {
+	    if (cache_count == CACHE_ENTRIES)
+		return;
+	    cache_count++;
+	}
+	strncpy(cache[i].name, t->name, sizeof(cache[i].name) - 1);
+	cache[i].hash = h;
+    } else if (i < cache_count)
+	cache[i] = cache[--cache_count];
+}
+
+static void save_cache() {
+    FILE *fp;
+    int i;
+
+    if (!use_cache || !(fp = fopen(CACHE_FILE, "w")))
+	return;
+    for (i = 0; i < cache_count; i++)
+	fprintf(fp, "%016llx %s\n", cache[i].hash, cache[i].name);
+    fclose(fp);
+}
+
+/*
+ * print_json - Print the results of grading (-G), given the number of
+ * errors found in each function and the results of checking it
+ * against the coding rules.  A function gets its correctness points
+ * if it follows the rules and passes, and its performance points if
+ * it is also within its operator limit.  Operators are counted as dlc
+ * counts them in bits.c after zapping the functions that break the
+ * rules, so that the counts match those of the driver's other modes
+ */
+static void print_json(int results[], rule_result_t rules[]) {
+    int c_points = 0, c_max = 0, p_points = 0, p_max = 0, tops = 0;
+    char *sep = "";
+    int i;
+
+    printf("{\n  \"puzzles\": [");
+    for (i = 0; test_set[i].solution_funct; i++) {
+	test_ptr t = &test_set[i];
+	rule_result_t *r = &rules[i];
+	int rating = global_rating ? global_rating : t->rating;
+	int ok = results[i] == 0;
+	int ops = !r->name ? 0 : r->errors ? r->zap_ops : r->ops;
+	int perf = ok && r->name && r->ops <= t->op_limit ? PERF_RATING : 0;
+
+	if (test_fname && strcmp(t->name, test_fname) != 0)
+	    continue;
+	printf("%s\n    {\"name\": \"%s\", \"correctness\": %d, \"rating\": %d, "
+	       "\"errors\": %d, \"performance\": %d, \"ops\": %d, "
+	       "\"max_ops\": %d, \"violations\": %d}",
+	       sep, t->name, ok ? rating : 0, rating, results[i], perf, ops,
+	       t->op_limit, r->name ? r->errors : 0);
+	sep = ",";
+	c_points += ok ? rating : 0;
+	c_max += rating;
+	p_points += perf;
+	p_max += PERF_RATING;
+	tops += ops;
+    }
+    printf("\n  ],\n");
+    printf("  \"correctness\": %d,\n  \"correctness_max\": %d,\n", c_points, c_max);
+    printf("  \"performance\": %d,\n  \"performance_max\": %d,\n", p_points, p_max);
+    printf("  \"ops\": %d\n}\n", tops);
 }
 
 /* 
@@ -423,12 +2233,60 @@ static int test_function(test_ptr t) {
  */ 
 static int run_tests() 
 {
-    int i;
+    int i, n;
     int errors = 0;
     double points = 0.0;
     double max_points = 0.0;
-
-    printf("Score\tRating\tErrors\tFunction\n");
+    puzzle_t *puzzles = NULL;
+    rule_result_t rules[256];
+    int *cached, *zapped, *results;
+
+    for (n = 0; test_set[n].solution_funct; n++)
+	;
+    cached = calloc(n, sizeof(int));
+    zapped = calloc(n, sizeof(int));
+    results = calloc(n, sizeof(int));
+    if (!cached || !zapped || !results) {
+	printf("Couldn't allocate space for test values\n");
+	exit(1);
+    }
+    if (rule_flags) {
+	/* With -G, problems go to stderr, where the student sees them */
+	if (!check_rules(rules, json ? stderr : grade ? NULL : stdout)) {
+	    printf("Couldn't check bits.c against the coding rules\n");
+	    exit(1);
+	}
+	for (i = 0; i < n; i++)
+	    zapped[i] = rules[i].name && rules_zapped(&rules[i], rule_flags);
+    }
+    for (i = 0; i < n; i++)
+	cached[i] = !zapped[i] && in_cache(&test_set[i]);
+
+    if (!json)
+	printf("Score\tRating\tErrors\tFunction\n");
+
+    /* In parallel and forked modes, all the functions are tested
+       together before any results are printed.  The tests on
+       boundary values come first, in puzzles[0..n-1], followed by
+       the sampled tests, in puzzles[n..2n-1] */
+    if (nthreads > 0) {
+	puzzles = calloc(2 * n, sizeof(puzzle_t));
+	if (!puzzles) {
+	    printf("Couldn't allocate space for test values\n");
+	    exit(1);
+	}
+	for (i = 0; i < n; i++)
+	    if ((!test_fname || strcmp(test_set[i].name,test_fname) == 0)
+		&& !cached[i] && !zapped[i]) {
+		if (has_boundary(&test_set[i]) && fuzz_time == 0)
+		    prepare_test(&puzzles[i], &test_set[i], 1);
+		prepare_test(&puzzles[n + i], &test_set[i], 0);
+	    }
+	if (forked)
+	    test_forked(puzzles, 2 * n);
+	else
+	    test_parallel(puzzles, 2 * n);
+    }
 
     for (i = 0; test_set[i].solution_funct; i++) {
 	int terrors;
@@ -436,28 +2294,63 @@ static int run_tests()
 	double tpoints;
 	if (!test_fname || strcmp(test_set[i].name,test_fname) == 0) {
 	    int rating = global_rating ? global_rating : test_set[i].rating;
-	    terrors = test_function(&test_set[i]);
+	    if (zapped[i]) {
+		if (!grade)
+		    printf("ERROR: %s %s\n", test_set[i].name,
+			   rules[i].errors ? "breaks the coding rules"
+			   : "uses too many operators");
+		terrors = 1;
+	    } else if (cached[i])
+		terrors = 0;
+	    else {
+		if (puzzles) {
+		    /* A failure on the boundary values is reported first */
+		    puzzle_t *p = &puzzles[i];
+		    if (!p->t || (!p->timed_out && !p->crashed
+				  && p->fail_index == LLONG_MAX))
+			p = &puzzles[n + i];
+		    terrors = report_test(p);
+		} else
+		    terrors = test_function(&test_set[i]);
+		update_cache(&test_set[i], terrors == 0);
+	    }
 	    errors += terrors;
+	    results[i] = terrors;
 	    tscore = terrors == 0 ? 1.0 : 0.0;
 	    tpoints = rating * tscore;
 	    points += tpoints;
 	    max_points += rating;
 
-	    if (grade || terrors < 1)
-		printf(" %.0f\t%d\t%d\t%s\n", 
-		       tpoints, rating, terrors, test_set[i].name);
+	    if (json)
+		;
+	    else if (grade || terrors < 1)
+		printf(" %.0f\t%d\t%d\t%s%s\n", 
+		       tpoints, rating, terrors, test_set[i].name,
+		       cached[i] ? " (passed before)" : "");
+	    if (fuzz_time > 0 && !grade) {
+		puzzle_t *p = &puzzles[n + i];
+		printf("  %lld tests, %d inputs kept, %d kinds of values seen\n",
+		       p->fuzz_runs, p->fuzz_kept, p->fuzz_features);
+	    }
 
 	}
     }
 
-    printf("Total points: %.0f/%.0f\n", points, max_points);
+    if (json)
+	print_json(results, rules);
+    else
+	printf("Total points: %.0f/%.0f\n", points, max_points);
+    save_cache();
+    free(cached);
+    free(zapped);
+    free(results);
     return errors;
 }
 
 /* 
  * get_num_val - Extract hex/decimal/or float value from string 
  */
-static int get_num_val(char *sval, unsigned *valp) {
+static int get_num_val(char *sval, long long *valp) {
     char *endp;
 
     /* See if it's an integer or floating point */
@@ -485,36 +2378,73 @@ static int get_num_val(char *sval, unsigned *valp) {
     if (isfloat) {
 	float fval = strtof(sval, &endp);
 	if (!*endp) {
-	    *valp = *(unsigned *) &fval;
+	    *valp = *(int *) &fval;
 	    return 1;
 	}
 	return 0;
     } else {
-	long long int llval = strtoll(sval, &endp, 0);
-	long long int upperbits = llval >> 31;
-	/* will give -1 for negative, 0 or 1 for positive */
-	if (!*valp && (upperbits == 0 || upperbits == -1 || upperbits == 1)) {
-	    *valp = (unsigned) llval;
+	/* Values up to 64 bits.  check_arg_widths makes sure they fit
+	   the width of the function.  Negative values wrap around */
+	unsigned long long llval;
+	errno = 0;
+	llval = strtoull(sval, &endp, 0);
+	if (!*endp && errno == 0) {
+	    *valp = llval;
 	    return 1;
 	}
 	return 0;
     }
 }
 
+/*
+ * check_arg_widths - Make sure that the values given with -1, -2, and
+ * -3 fit the arguments of the functions to be tested, as signed or
+ * unsigned numbers, rather than quietly testing a truncated value
+ */
+static void check_arg_widths() {
+    int i, k, width;
+    long long v;
+
+    for (i = 0; test_set[i].solution_funct; i++) {
+	if (test_fname && strcmp(test_set[i].name, test_fname) != 0)
+	    continue;
+	width = width_of(&test_set[i]);
+	for (k = 0; k < test_set[i].args && k < 3; k++) {
+	    v = argval[k];
+	    if (has_arg[k] && sext(v, width) != v
+		&& ((unsigned long long) v & ~width_mask(width)) != 0) {
+		printf("Argument '%s' doesn't fit in the %d bits of %s\n",
+		       argstr[k], width, test_set[i].name);
+		exit(1);
+	    }
+	}
+    }
+}
+
 
 /* 
  * usage - Display usage info
  */
 static void usage(char *cmd) {
-    printf("Usage: %s [-hg] [-r <n>] [-f <name> [-1|-2|-3 <val>]*] [-T <time limit>]\n", cmd);
+    printf("Usage: %s [-hgGBcCFR] [-r <n>] [-f <name> [-1|-2|-3 <val>]*] [-s <seed>] [-T <time limit>] [-j <n>] [-X] [-Z <secs>]\n", cmd);
     printf("  -1 <val>  Specify first function argument\n");
     printf("  -2 <val>  Specify second function argument\n");
     printf("  -3 <val>  Specify third function argument\n");
+    printf("  -B        Measure time per call instead of testing\n");
+    printf("  -c        Fail functions that break the coding rules\n");
+    printf("  -C        Like -c, but also fail functions with too many operators\n");
     printf("  -f <name> Test only the named function\n");
+    printf("  -F        Test in child processes, n at a time with -j\n");
     printf("  -g        Compact output for grading (with no error msgs)\n");
+    printf("  -G        Grade correctness, performance, and operator counts as JSON\n");
     printf("  -h        Print this message\n");
+    printf("  -j <n>    Test in parallel with n threads\n");
     printf("  -r <n>    Give uniform weight of n for all problems\n");
+    printf("  -R        Retest functions that passed before\n");
+    printf("  -s <seed> Use seed to choose the random tests (default 0)\n");
+    printf("  -Z <secs> Fuzz each function for secs seconds, n at a time with -j\n");
     printf("  -T <lim>  Set timeout limit to lim\n");
+    printf("  -X        Test one-argument functions on every argument value\n");
     exit(1);
 }
 
@@ -526,9 +2456,10 @@ static void usage(char *cmd) {
 int main(int argc, char *argv[])
 {
     char c;
+    char *endp;
 
     /* parse command line args */
-    while ((c = getopt(argc, argv, "hgf:r:T:1:2:3:")) != -1)
+    while ((c = getopt(argc, argv, "hgGBcCFRf:r:s:T:j:XZ:1:2:3:")) != -1)
         switch (c) {
         case 'h': /* help */
 	    usage(argv[0]);
@@ -536,6 +2467,10 @@ int main(int argc, char *argv[])
 	case 'g': /* grading option for autograder */
 	    grade = 1;
 	    break;
+	case 'G': /* Grade everything at once, for the driver */
+	    grade = json = 1;
+	    rule_flags |= RULES_ZAP;
+	    break;
 	case 'f': /* test only one function */
 	    test_fname = strdup(optarg);
 	    break;
@@ -546,6 +2481,7 @@ int main(int argc, char *argv[])
 	    break;
 	case '1': /* Get first argument */
 	    has_arg[0] = get_num_val(optarg, &argval[0]);
+	    argstr[0] = optarg;
 	    if (!has_arg[0]) {
 		printf("Bad argument '%s'\n", optarg);
 		exit(0);
@@ -553,6 +2489,7 @@ int main(int argc, char *argv[])
 	    break;
 	case '2': /* Get first argument */
 	    has_arg[1] = get_num_val(optarg, &argval[1]);
+	    argstr[1] = optarg;
 	    if (!has_arg[1]) {
 		printf("Bad argument '%s'\n", optarg);
 		exit(0);
@@ -560,22 +2497,81 @@ int main(int argc, char *argv[])
 	    break;
 	case '3': /* Get first argument */
 	    has_arg[2] = get_num_val(optarg, &argval[2]);
+	    argstr[2] = optarg;
 	    if (!has_arg[2]) {
 		printf("Bad argument '%s'\n", optarg);
 		exit(0);
 	    }
 	    break;
+	case 's': /* Seed for the random tests */
+	    errno = 0;
+	    test_seed = strtoull(optarg, &endp, 0);
+	    if (*endp || errno != 0)
+		usage(argv[0]);
+	    break;
 	case 'T': /* Set timeout limit */
 	    timeout_limit = atoi(optarg);
 	    break;
+	case 'j': /* Set number of worker threads */
+	    nthreads = atoi(optarg);
+	    if (nthreads < 0)
+		usage(argv[0]);
+	    break;
+	case 'X': /* Exhaustive testing */
+	    exhaustive = 1;
+	    break;
+	case 'B': /* Benchmark */
+	    benchmark = 1;
+	    break;
+	case 'c': /* Check the coding rules */
+	    rule_flags |= RULES_ZAP;
+	    break;
+	case 'C': /* Check the coding rules and operator limits */
+	    rule_flags |= RULES_ZAP_OPS;
+	    break;
+	case 'F': /* Test in child processes */
+	    forked = 1;
+	    break;
+	case 'R': /* Ignore results of earlier runs */
+	    use_cache = 0;
+	    break;
+	case 'Z': /* Fuzz */
+	    fuzz_time = atoi(optarg);
+	    if (fuzz_time < 1)
+		usage(argv[0]);
+	    break;
 	default:
 	    usage(argv[0]);
 	}
 
+    /* Fuzzing is always done in child processes */
+    if (fuzz_time > 0)
+	forked = 1;
+
+    /* Exhaustive and forked testing use all of the processors, unless
+       told otherwise */
+    if ((exhaustive || forked) && nthreads == 0)
+	nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+
     if (timeout_limit > 0) {
 	Signal(SIGALRM, timeout_handler);
     }
 
+    if (benchmark) {
+	run_benchmarks();
+	return 0;
+    }
+
+    check_arg_widths();
+
+    /* Results of earlier runs don't count when grading, when
+       testing particular arguments or seeds, or when fuzzing */
+    if (grade || has_arg[0] || has_arg[1] || has_arg[2] || test_seed != 0
+	|| fuzz_time > 0)
+	use_cache = 0;
+    if (use_cache)
+	load_cache(argv[0]);
+
     /* test each function */
     run_tests();
 
@@ -8,6 +8,12 @@ typedef int (*funct1_t)(int);
 typedef int (*funct2_t)(int, int); 
 typedef int (*funct3_t)(int, int, int); 
 
+/* Function types for 64-bit puzzles */
+typedef long long (*lfunct_t) (void);
+typedef long long (*lfunct1_t)(long long);
+typedef long long (*lfunct2_t)(long long, long long);
+typedef long long (*lfunct3_t)(long long, long long, long long);
+
 /* Combine all the information about a function and its tests as structure */
 typedef struct {
     char *name;             /* String name */
@@ -17,13 +23,29 @@ typedef struct {
     char *ops;              /* List of legal operators. Special case: "$" for floating point */
     int op_limit;           /* Max number of ops allowed in solution */
     int rating;             /* Problem rating (1 -- 4) */
-    int arg_ranges[3][2];   /* Argument ranges. Always defined for 3 args, even if */
+    long long arg_ranges[3][2]; /* Argument ranges. Always defined for 3 args, even if */
                             /* the function takes fewer. Special case: First arg */
 			    /* must be set to {1,1} for f.p. puzzles */
+    int width;              /* Bits in the arguments and result: 8, 16, 32 or 64. */
+                            /* 0 means 32.  64-bit puzzles take and return */
+                            /* long long, the others int */
 } test_rec, *test_ptr;
 
 extern test_rec test_set[];
 
+/* Batch kernel: evaluate function and its reference on the argument
+   lists (a1, a2, x[k]) for k = 0..n-1, with x[k] as the last
+   argument.  Return first k where they disagree, or -1 */
+typedef int (*batch_funct_t)(int a1, int a2, const int x[], int n);
+
+typedef struct {
+    char *name;
+    batch_funct_t batch_funct;
+} batch_rec;
+
+/* Defined in batch.c */
+extern batch_rec batch_set[];
+
 
 
 
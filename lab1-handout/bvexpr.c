@@ -0,0 +1,1638 @@
+/*
+ * CS 208 Lab 1: Data Lab
+ *
+ * bvexpr.c - Parse C functions and evaluate them symbolically, as
+ * vectors of bits
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include "bvexpr.h"
+
+/* Maximum number of times a loop body is unrolled */
+#define LOOP_LIMIT 1024
+
+/* Maximum depth of nested function calls */
+#define CALL_LIMIT 32
+
+/* Maximum depth of macro expansion */
+#define MACRO_LIMIT 16
+
+#define MAX_MSG 256
+
+static ctype_t int_type = {32, 1};
+
+/*********
+ * Lexer
+ *********/
+
+#define T_EOF   0
+#define T_IDENT 1
+#define T_NUM   2
+#define T_OP    3
+
+typedef struct {
+    int kind;
+    char *text;             /* Identifier or operator */
+    unsigned long long val; /* Value of number */
+    ctype_t type;           /* Type of number */
+    int line;
+} token_t;
+
+static token_t *tokens = NULL;
+static int ntokens = 0;
+static int alloc_tokens = 0;
+
+/* Object-like macros from #define lines */
+typedef struct MACRO_ELE macro_ele, *macro_ptr;
+struct MACRO_ELE {
+    char *name;
+    token_t *body;
+    int len;
+    macro_ptr next;
+};
+
+static macro_ptr macros = NULL;
+
+static char *fname = NULL;
+
+static void *bv_malloc(size_t size) {
+    void *p = calloc(1, size);
+    if (!p) {
+	printf("Couldn't allocate space for parsing\n");
+	exit(1);
+    }
+    return p;
+}
+
+static char *bv_strndup(char *s, int len) {
+    char *r = bv_malloc(len + 1);
+    memcpy(r, s, len);
+    return r;
+}
+
+static void add_token(token_t *t) {
+    if (ntokens == alloc_tokens) {
+	alloc_tokens = alloc_tokens ? 2 * alloc_tokens : 1024;
+	tokens = realloc(tokens, alloc_tokens * sizeof(token_t));
+	if (!tokens) {
+	    printf("Couldn't allocate space for parsing\n");
+	    exit(1);
+	}
+    }
+    tokens[ntokens++] = *t;
+}
+
+/* Operators, longest first so that the longest match is taken */
+static char *op_list[] = {
+    "<<=", ">>=", "...",
+    "<<", ">>", "<=", ">=", "==", "!=", "&&", "||", "++", "--", "->",
+    "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=",
+    "+", "-", "*", "/", "%", "<", ">", "=", "!", "~", "&", "|", "^",
+    "?", ":", ";", ",", "(", ")", "{", "}", "[", "]", ".",
+    NULL
+};
+
+/* Type of integer constant, following the C rules for 64-bit Linux */
+static ctype_t const_type(unsigned long long val, int decimal,
+			  int is_unsigned, int is_long) {
+    ctype_t t;
+    if (!is_long && !is_unsigned && val <= 0x7fffffff)
+	t.width = 32, t.is_signed = 1;
+    else if (!is_long && (is_unsigned || !decimal) && val <= 0xffffffff)
+	t.width = 32, t.is_signed = 0;
+    else if (!is_unsigned && val <= 0x7fffffffffffffffULL)
+	t.width = 64, t.is_signed = 1;
+    else
+	t.width = 64, t.is_signed = 0;
+    return t;
+}
+
+/* Lexer position */
+static char *lex_pos;
+static int lex_line;
+static int lex_bol;         /* At beginning of line? */
+
+static int scan_token(token_t *t);
+
+static macro_ptr find_macro(char *name) {
+    macro_ptr m;
+    for (m = macros; m; m = m->next)
+	if (strcmp(m->name, name) == 0)
+	    return m;
+    return NULL;
+}
+
+/* Add token, expanding it if it names a macro */
+static void expand_token(token_t *t, int depth) {
+    macro_ptr m = NULL;
+    int i;
+
+    if (t->kind == T_IDENT && depth < MACRO_LIMIT)
+	m = find_macro(t->text);
+    if (!m) {
+	add_token(t);
+	return;
+    }
+    for (i = 0; i < m->len; i++) {
+	token_t b = m->body[i];
+	b.line = t->line;
+	expand_token(&b, depth + 1);
+    }
+}
+
+/* Word of directive on line starting at s, or NULL if not a directive */
+static char *directive_word(char *s) {
+    while (*s == ' ' || *s == '\t')
+	s++;
+    if (*s != '#')
+	return NULL;
+    s++;
+    while (*s == ' ' || *s == '\t')
+	s++;
+    return s;
+}
+
+static int is_directive(char *word, char *name) {
+    int len = strlen(name);
+    return strncmp(word, name, len) == 0 && !isalnum((int) word[len]);
+}
+
+/* Skip lines of #if 0 group, starting at end of its #if line.
+   Return position of the #else or #endif that ends it */
+static char *skip_group(char *s) {
+    int depth = 0;
+    while (*s) {
+	char *word;
+	if (*s == '\n') {
+	    lex_line++;
+	    s++;
+	}
+	word = directive_word(s);
+	if (word) {
+	    if (is_directive(word, "if") || is_directive(word, "ifdef")
+		|| is_directive(word, "ifndef"))
+		depth++;
+	    else if (depth == 0 && (is_directive(word, "endif")
+				    || is_directive(word, "else")))
+		break;
+	    else if (is_directive(word, "endif"))
+		depth--;
+	}
+	while (*s && *s != '\n')
+	    s++;
+    }
+    return s;
+}
+
+/* Handle preprocessor line at lex_pos.  Only object-like #define
+   lines and #if 0 groups have any effect.  Other conditionals are
+   ignored, so that the code in both branches is seen */
+static void directive() {
+    char *s = lex_pos + 1;
+    char *end = s;
+    char *name;
+    int len;
+
+    while (*end && *end != '\n') {
+	if (end[0] == '\\' && end[1] == '\n') {
+	    end++;
+	    lex_line++;
+	}
+	end++;
+    }
+    while (*s == ' ' || *s == '\t')
+	s++;
+    if (is_directive(s, "if")) {
+	s += 2;
+	while (*s == ' ' || *s == '\t')
+	    s++;
+	if (s[0] == '0' && !isalnum((int) s[1])) {
+	    /* Resume after the #else or #endif line */
+	    for (lex_pos = skip_group(end); *lex_pos && *lex_pos != '\n';)
+		lex_pos++;
+	    return;
+	}
+    }
+    if (strncmp(s, "define", 6) == 0 && (s[6] == ' ' || s[6] == '\t')) {
+	s += 6;
+	while (*s == ' ' || *s == '\t')
+	    s++;
+	name = s;
+	while (isalnum((int) *s) || *s == '_')
+	    s++;
+	len = s - name;
+	/* Function-like macros are not supported */
+	if (len > 0 && *s != '(') {
+	    macro_ptr m = bv_malloc(sizeof(macro_ele));
+	    int first = ntokens;
+	    char save = *end;
+	    token_t t;
+	    *end = '\0';
+	    lex_pos = s;
+	    while (scan_token(&t))
+		add_token(&t);
+	    *end = save;
+	    m->name = bv_strndup(name, len);
+	    m->len = ntokens - first;
+	    m->body = bv_malloc((m->len + 1) * sizeof(token_t));
+	    memcpy(m->body, tokens + first, m->len * sizeof(token_t));
+	    ntokens = first;
+	    m->next = macros;
+	    macros = m;
+	}
+    }
+    lex_pos = end;
+}
+
+/* Scan next token into t.  Return 0 at end of text */
+static int scan_token(token_t *t) {
+    char *s;
+    int i;
+
+    for (;;) {
+	s = lex_pos;
+	if (*s == '\n') {
+	    lex_line++;
+	    lex_bol = 1;
+	    lex_pos++;
+	} else if (isspace((int) *s) || *s == '\\')
+	    lex_pos++;
+	else if (*s == '#' && lex_bol)
+	    directive();
+	else if (s[0] == '/' && s[1] == '*') {
+	    for (s += 2; *s && !(s[0] == '*' && s[1] == '/'); s++)
+		if (*s == '\n')
+		    lex_line++;
+	    lex_pos = *s ? s + 2 : s;
+	} else if (s[0] == '/' && s[1] == '/') {
+	    while (*s && *s != '\n')
+		s++;
+	    lex_pos = s;
+	} else
+	    break;
+    }
+    if (!*s)
+	return 0;
+    lex_bol = 0;
+
+    memset(t, 0, sizeof(token_t));
+    t->line = lex_line;
+    if (isalpha((int) *s) || *s == '_') {
+	char *start = s;
+	while (isalnum((int) *s) || *s == '_')
+	    s++;
+	t->kind = T_IDENT;
+	t->text = bv_strndup(start, s - start);
+    } else if (isdigit((int) *s)) {
+	int is_unsigned = 0, is_long = 0;
+	char *start = s;
+	t->kind = T_NUM;
+	t->val = strtoull(start, &s, 0);
+	for (;; s++) {
+	    if (*s == 'u' || *s == 'U')
+		is_unsigned = 1;
+	    else if (*s == 'l' || *s == 'L')
+		is_long = 1;
+	    else
+		break;
+	}
+	t->type = const_type(t->val, start[0] != '0', is_unsigned, is_long);
+    } else if (*s == '\'') {
+	/* Character constant */
+	t->kind = T_NUM;
+	t->type = int_type;
+	s++;
+	if (*s == '\\') {
+	    s++;
+	    switch (*s) {
+	    case 'n': t->val = '\n'; break;
+	    case 't': t->val = '\t'; break;
+	    case '0': t->val = 0; break;
+	    default: t->val = *s; break;
+	    }
+	} else
+	    t->val = *s;
+	if (*s)
+	    s++;
+	if (*s == '\'')
+	    s++;
+    } else {
+	t->kind = T_OP;
+	for (i = 0; op_list[i]; i++) {
+	    int len = strlen(op_list[i]);
+	    if (strncmp(s, op_list[i], len) == 0) {
+		t->text = op_list[i];
+		s += len;
+		break;
+	    }
+	}
+	/* Unknown character.  Pass it on, for the parser to reject */
+	if (!t->text)
+	    t->text = bv_strndup(s++, 1);
+    }
+    lex_pos = s;
+    return 1;
+}
+
+/* Split text into tokens, ending with a T_EOF token */
+static void tokenize(char *text) {
+    token_t t;
+
+    ntokens = 0;
+    lex_pos = text;
+    lex_line = 1;
+    lex_bol = 1;
+    while (scan_token(&t))
+	expand_token(&t, 0);
+    memset(&t, 0, sizeof(t));
+    t.kind = T_EOF;
+    t.line = lex_line;
+    add_token(&t);
+}
+
+/*********
+ * Parser
+ *********/
+
+/* Expression kinds */
+#define E_NUM    0
+#define E_VAR    1
+#define E_UNARY  2          /* op: - ~ ! + */
+#define E_BINARY 3
+#define E_COND   4
+#define E_ASSIGN 5          /* op: = or compound assignment */
+#define E_INCDEC 6          /* op: ++ or --, post set for postfix */
+#define E_CAST   7
+#define E_CALL   8
+#define E_COMMA  9
+
+typedef struct EXPR_ELE expr_ele, *expr_ptr;
+struct EXPR_ELE {
+    int kind;
+    char *op;
+    int post;
+    unsigned long long val;
+    ctype_t type;           /* For constants and casts */
+    char *name;             /* For variables and calls */
+    expr_ptr a, b, c;       /* Operands.  Call arguments are linked by next */
+    expr_ptr next;
+    int line;
+    int site;               /* Number of expression, for observe */
+};
+
+/* Statement kinds */
+#define S_EMPTY    0
+#define S_EXPR     1
+#define S_DECL     2        /* name, type, optional init */
+#define S_BLOCK    3
+#define S_IF       4
+#define S_SWITCH   5
+#define S_CASE     6
+#define S_DEFAULT  7
+#define S_BREAK    8
+#define S_CONTINUE 9
+#define S_RETURN   10
+#define S_FOR      11       /* Also used for while loops */
+#define S_DO       12
+#define S_DECLS    13       /* List of S_DECL in body */
+
+typedef struct STMT_ELE stmt_ele, *stmt_ptr;
+struct STMT_ELE {
+    int kind;
+    char *name;
+    ctype_t type;
+    expr_ptr e;             /* Expression, condition, or initializer */
+    expr_ptr step;          /* Loop step */
+    stmt_ptr init;          /* Loop initialization */
+    stmt_ptr body;          /* Body, then branch, or block contents */
+    stmt_ptr other;         /* Else branch */
+    stmt_ptr next;          /* Next statement in block */
+    int line;
+};
+
+#define MAX_PARAMS 8
+
+struct FUNC_ELE {
+    char *name;
+    char *file;
+    ctype_t ret_type;
+    int nparams;
+    char *param_names[MAX_PARAMS];
+    ctype_t param_types[MAX_PARAMS];
+    stmt_ptr body;
+    char *error;
+    func_ptr next;
+};
+
+static func_ptr funcs = NULL;
+
+/* Parsing state */
+static int pos;
+static jmp_buf parse_env;
+static char parse_msg[MAX_MSG];
+
+static void parse_error(char *fmt, ...) {
+    va_list ap;
+    int len;
+    len = snprintf(parse_msg, MAX_MSG, "%s:%d: ", fname, tokens[pos].line);
+    va_start(ap, fmt);
+    vsnprintf(parse_msg + len, MAX_MSG - len, fmt, ap);
+    va_end(ap);
+    longjmp(parse_env, 1);
+}
+
+static int is_op(char *op) {
+    return tokens[pos].kind == T_OP && strcmp(tokens[pos].text, op) == 0;
+}
+
+static int is_word(char *word) {
+    return tokens[pos].kind == T_IDENT && strcmp(tokens[pos].text, word) == 0;
+}
+
+static void expect(char *op) {
+    if (!is_op(op))
+	parse_error("expected '%s'", op);
+    pos++;
+}
+
+static char *tok_desc() {
+    switch (tokens[pos].kind) {
+    case T_EOF:
+	return "end of file";
+    case T_NUM:
+	return "number";
+    default:
+	return tokens[pos].text;
+    }
+}
+
+/*
+ * Type names.  Return 1 if the current token starts a type
+ */
+static char *type_words[] = {
+    "int", "unsigned", "signed", "char", "short", "long", "void",
+    "const", "volatile", "register", "static", "extern", "inline",
+    "float", "double", "struct", "union", "enum", "_Bool",
+    NULL
+};
+
+static int is_type() {
+    int i;
+    if (tokens[pos].kind != T_IDENT)
+	return 0;
+    for (i = 0; type_words[i]; i++)
+	if (strcmp(tokens[pos].text, type_words[i]) == 0)
+	    return 1;
+    return 0;
+}
+
+/* Parse type.  Width 0 indicates void */
+static ctype_t parse_type() {
+    int nunsigned = 0, nsigned = 0, nchar = 0, nshort = 0, nlong = 0;
+    int nint = 0, nvoid = 0;
+    ctype_t t;
+
+    if (!is_type())
+	parse_error("expected type, found '%s'", tok_desc());
+    while (is_type()) {
+	char *w = tokens[pos].text;
+	if (strcmp(w, "float") == 0 || strcmp(w, "double") == 0
+	    || strcmp(w, "struct") == 0 || strcmp(w, "union") == 0
+	    || strcmp(w, "enum") == 0 || strcmp(w, "_Bool") == 0)
+	    parse_error("type '%s' not supported", w);
+	nunsigned += strcmp(w, "unsigned") == 0;
+	nsigned += strcmp(w, "signed") == 0;
+	nchar += strcmp(w, "char") == 0;
+	nshort += strcmp(w, "short") == 0;
+	nlong += strcmp(w, "long") == 0;
+	nint += strcmp(w, "int") == 0;
+	nvoid += strcmp(w, "void") == 0;
+	pos++;
+    }
+    if (is_op("*"))
+	parse_error("pointers not supported");
+    t.is_signed = !nunsigned;
+    if (nvoid)
+	t.width = 0;
+    else if (nchar)
+	t.width = 8;
+    else if (nshort)
+	t.width = 16;
+    else if (nlong)
+	t.width = 64;
+    else
+	t.width = 32;
+    return t;
+}
+
+static int nsites = 0;
+
+static expr_ptr new_expr(int kind) {
+    expr_ptr e = bv_malloc(sizeof(expr_ele));
+    e->kind = kind;
+    e->line = tokens[pos].line;
+    e->site = nsites++;
+    return e;
+}
+
+static expr_ptr parse_expr();
+static expr_ptr parse_assign();
+
+static expr_ptr parse_primary() {
+    expr_ptr e;
+    if (tokens[pos].kind == T_NUM) {
+	e = new_expr(E_NUM);
+	e->val = tokens[pos].val;
+	e->type = tokens[pos].type;
+	pos++;
+	return e;
+    }
+    if (tokens[pos].kind == T_IDENT && !is_type()) {
+	e = new_expr(E_VAR);
+	e->name = tokens[pos].text;
+	pos++;
+	if (is_op("(")) {
+	    /* Function call */
+	    expr_ptr *last = &e->a;
+	    e->kind = E_CALL;
+	    pos++;
+	    while (!is_op(")")) {
+		*last = parse_assign();
+		last = &(*last)->next;
+		if (!is_op(")"))
+		    expect(",");
+	    }
+	    pos++;
+	}
+	return e;
+    }
+    if (is_op("(")) {
+	pos++;
+	e = parse_expr();
+	expect(")");
+	return e;
+    }
+    parse_error("unexpected '%s'", tok_desc());
+    return NULL;
+}
+
+static expr_ptr parse_postfix() {
+    expr_ptr e = parse_primary();
+    while (is_op("++") || is_op("--")) {
+	expr_ptr p = new_expr(E_INCDEC);
+	p->op = tokens[pos++].text;
+	p->post = 1;
+	p->a = e;
+	e = p;
+    }
+    if (is_op("[") || is_op(".") || is_op("->"))
+	parse_error("operator '%s' not supported", tok_desc());
+    return e;
+}
+
+static expr_ptr parse_unary() {
+    expr_ptr e;
+    if (is_op("-") || is_op("+") || is_op("!") || is_op("~")) {
+	e = new_expr(E_UNARY);
+	e->op = tokens[pos++].text;
+	e->a = parse_unary();
+	return e;
+    }
+    if (is_op("++") || is_op("--")) {
+	e = new_expr(E_INCDEC);
+	e->op = tokens[pos++].text;
+	e->a = parse_unary();
+	return e;
+    }
+    if (is_op("*") || is_op("&"))
+	parse_error("pointers not supported");
+    if (is_word("sizeof")) {
+	pos++;
+	e = new_expr(E_NUM);
+	expect("(");
+	e->val = parse_type().width / 8;
+	e->type.width = 64;
+	e->type.is_signed = 0;
+	expect(")");
+	return e;
+    }
+    if (is_op("(") && tokens[pos+1].kind == T_IDENT) {
+	int save = pos++;
+	if (is_type()) {
+	    e = new_expr(E_CAST);
+	    e->type = parse_type();
+	    expect(")");
+	    e->a = parse_unary();
+	    return e;
+	}
+	pos = save;
+    }
+    return parse_postfix();
+}
+
+/* Binary operators by precedence level, lowest first */
+static char *binary_ops[][5] = {
+    {"||", NULL},
+    {"&&", NULL},
+    {"|", NULL},
+    {"^", NULL},
+    {"&", NULL},
+    {"==", "!=", NULL},
+    {"<", ">", "<=", ">=", NULL},
+    {"<<", ">>", NULL},
+    {"+", "-", NULL},
+    {"*", "/", "%", NULL},
+};
+
+#define NLEVELS (sizeof(binary_ops) / sizeof(binary_ops[0]))
+
+static expr_ptr parse_binary(int level) {
+    expr_ptr e;
+    int i;
+
+    if (level == NLEVELS)
+	return parse_unary();
+    e = parse_binary(level + 1);
+    for (;;) {
+	for (i = 0; binary_ops[level][i]; i++)
+	    if (is_op(binary_ops[level][i]))
+		break;
+	if (!binary_ops[level][i])
+	    return e;
+	expr_ptr b = new_expr(E_BINARY);
+	b->op = tokens[pos++].text;
+	b->a = e;
+	b->b = parse_binary(level + 1);
+	e = b;
+    }
+}
+
+static expr_ptr parse_cond() {
+    expr_ptr e = parse_binary(0);
+    if (is_op("?")) {
+	expr_ptr c = new_expr(E_COND);
+	pos++;
+	c->a = e;
+	c->b = parse_expr();
+	expect(":");
+	c->c = parse_cond();
+	return c;
+    }
+    return e;
+}
+
+static char *assign_ops[] = {
+    "=", "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", "<<=", ">>=", NULL
+};
+
+static expr_ptr parse_assign() {
+    expr_ptr e = parse_cond();
+    int i;
+    for (i = 0; assign_ops[i]; i++)
+	if (is_op(assign_ops[i])) {
+	    expr_ptr a = new_expr(E_ASSIGN);
+	    if (e->kind != E_VAR)
+		parse_error("can only assign to variables");
+	    a->op = tokens[pos++].text;
+	    a->a = e;
+	    a->b = parse_assign();
+	    return a;
+	}
+    return e;
+}
+
+static expr_ptr parse_expr() {
+    expr_ptr e = parse_assign();
+    while (is_op(",")) {
+	expr_ptr c = new_expr(E_COMMA);
+	pos++;
+	c->a = e;
+	c->b = parse_assign();
+	e = c;
+    }
+    return e;
+}
+
+static stmt_ptr new_stmt(int kind) {
+    stmt_ptr s = bv_malloc(sizeof(stmt_ele));
+    s->kind = kind;
+    s->line = tokens[pos].line;
+    return s;
+}
+
+/* Parse declaration of one or more variables */
+static stmt_ptr parse_decl() {
+    stmt_ptr block = new_stmt(S_DECLS);
+    stmt_ptr *last = &block->body;
+    ctype_t t = parse_type();
+
+    if (t.width == 0)
+	parse_error("void variable");
+    for (;;) {
+	stmt_ptr s = new_stmt(S_DECL);
+	s->type = t;
+	if (tokens[pos].kind != T_IDENT)
+	    parse_error("expected variable name, found '%s'", tok_desc());
+	s->name = tokens[pos++].text;
+	if (is_op("["))
+	    parse_error("arrays not supported");
+	if (is_op("=")) {
+	    pos++;
+	    s->e = parse_assign();
+	}
+	*last = s;
+	last = &s->next;
+	if (!is_op(","))
+	    break;
+	pos++;
+    }
+    expect(";");
+    return block;
+}
+
+static stmt_ptr parse_stmt() {
+    stmt_ptr s;
+
+    if (is_op("{")) {
+	stmt_ptr *last;
+	s = new_stmt(S_BLOCK);
+	last = &s->body;
+	pos++;
+	while (!is_op("}")) {
+	    if (tokens[pos].kind == T_EOF)
+		parse_error("missing '}'");
+	    *last = parse_stmt();
+	    last = &(*last)->next;
+	}
+	pos++;
+	return s;
+    }
+    if (is_type())
+	return parse_decl();
+    if (is_op(";")) {
+	s = new_stmt(S_EMPTY);
+	pos++;
+	return s;
+    }
+    if (is_word("if")) {
+	s = new_stmt(S_IF);
+	pos++;
+	expect("(");
+	s->e = parse_expr();
+	expect(")");
+	s->body = parse_stmt();
+	if (is_word("else")) {
+	    pos++;
+	    s->other = parse_stmt();
+	}
+	return s;
+    }
+    if (is_word("switch")) {
+	s = new_stmt(S_SWITCH);
+	pos++;
+	expect("(");
+	s->e = parse_expr();
+	expect(")");
+	s->body = parse_stmt();
+	if (s->body->kind != S_BLOCK)
+	    parse_error("switch body must be a block");
+	return s;
+    }
+    if (is_word("case")) {
+	s = new_stmt(S_CASE);
+	pos++;
+	s->e = parse_cond();
+	expect(":");
+	return s;
+    }
+    if (is_word("default")) {
+	s = new_stmt(S_DEFAULT);
+	pos++;
+	expect(":");
+	return s;
+    }
+    if (is_word("break") || is_word("continue")) {
+	s = new_stmt(is_word("break") ? S_BREAK : S_CONTINUE);
+	pos++;
+	expect(";");
+	return s;
+    }
+    if (is_word("return")) {
+	s = new_stmt(S_RETURN);
+	pos++;
+	if (!is_op(";"))
+	    s->e = parse_expr();
+	expect(";");
+	return s;
+    }
+    if (is_word("while")) {
+	s = new_stmt(S_FOR);
+	pos++;
+	expect("(");
+	s->e = parse_expr();
+	expect(")");
+	s->body = parse_stmt();
+	return s;
+    }
+    if (is_word("do")) {
+	s = new_stmt(S_DO);
+	pos++;
+	s->body = parse_stmt();
+	if (!is_word("while"))
+	    parse_error("expected 'while'");
+	pos++;
+	expect("(");
+	s->e = parse_expr();
+	expect(")");
+	expect(";");
+	return s;
+    }
+    if (is_word("for")) {
+	s = new_stmt(S_FOR);
+	pos++;
+	expect("(");
+	if (is_type())
+	    s->init = parse_decl();
+	else {
+	    s->init = new_stmt(S_EXPR);
+	    if (!is_op(";"))
+		s->init->e = parse_expr();
+	    expect(";");
+	}
+	if (!is_op(";"))
+	    s->e = parse_expr();
+	expect(";");
+	if (!is_op(")"))
+	    s->step = parse_expr();
+	expect(")");
+	s->body = parse_stmt();
+	return s;
+    }
+    if (is_word("goto"))
+	parse_error("goto not supported");
+    s = new_stmt(S_EXPR);
+    s->e = parse_expr();
+    expect(";");
+    return s;
+}
+
+/* Skip to end of declaration or body at top level */
+static void skip_external() {
+    int depth = 0;
+    while (tokens[pos].kind != T_EOF) {
+	if (is_op("{"))
+	    depth++;
+	else if (is_op("}")) {
+	    if (--depth <= 0) {
+		pos++;
+		/* Closing brace of struct etc. may be followed by ';' */
+		if (is_op(";"))
+		    pos++;
+		return;
+	    }
+	} else if (is_op(";") && depth == 0) {
+	    pos++;
+	    return;
+	}
+	pos++;
+    }
+}
+
+/* Index of token following matching brace for '{' at position open */
+static int match_brace(int open) {
+    int depth = 0;
+    int i;
+    for (i = open; tokens[i].kind != T_EOF; i++) {
+	if (tokens[i].kind != T_OP)
+	    continue;
+	if (strcmp(tokens[i].text, "{") == 0)
+	    depth++;
+	else if (strcmp(tokens[i].text, "}") == 0 && --depth == 0)
+	    return i + 1;
+    }
+    return i;
+}
+
+static void add_func(func_ptr f) {
+    func_ptr *last = &funcs;
+    while (*last) {
+	if (strcmp((*last)->name, f->name) == 0) {
+	    /* Later definition replaces earlier one */
+	    f->next = (*last)->next;
+	    *last = f;
+	    return;
+	}
+	last = &(*last)->next;
+    }
+    *last = f;
+}
+
+/*
+ * Check whether the declaration at pos is a function definition, of
+ * the form "type name (params) {".  If so, set positions of the name
+ * and the opening brace of the body
+ */
+static int find_definition(int *name_pos, int *body_pos) {
+    int i, depth = 0;
+
+    if (is_word("typedef"))
+	return 0;
+    for (i = pos; tokens[i].kind != T_EOF; i++) {
+	if (tokens[i].kind == T_IDENT && tokens[i+1].kind == T_OP
+	    && strcmp(tokens[i+1].text, "(") == 0)
+	    break;
+	if (tokens[i].kind == T_OP && (strcmp(tokens[i].text, ";") == 0
+				       || strcmp(tokens[i].text, "{") == 0))
+	    return 0;
+    }
+    if (tokens[i].kind == T_EOF)
+	return 0;
+    *name_pos = i;
+    for (i++; tokens[i].kind != T_EOF; i++) {
+	if (tokens[i].kind != T_OP)
+	    continue;
+	if (strcmp(tokens[i].text, "(") == 0)
+	    depth++;
+	else if (strcmp(tokens[i].text, ")") == 0 && --depth == 0)
+	    break;
+    }
+    if (tokens[i].kind == T_EOF || tokens[i+1].kind != T_OP
+	|| strcmp(tokens[i+1].text, "{") != 0)
+	return 0;
+    *body_pos = i + 1;
+    return 1;
+}
+
+/*
+ * Parse one external declaration.  Function definitions are recorded,
+ * and everything else is skipped.
+ */
+static void parse_external() {
+    int name_pos, body_pos;
+    func_ptr f;
+
+    if (!find_definition(&name_pos, &body_pos)) {
+	skip_external();
+	return;
+    }
+    f = bv_malloc(sizeof(func_ele));
+    f->name = tokens[name_pos].text;
+    f->file = fname;
+    if (setjmp(parse_env)) {
+	/* Record error with function, and skip rest of it */
+	f->error = bv_strndup(parse_msg, strlen(parse_msg));
+	f->body = NULL;
+	add_func(f);
+	pos = match_brace(body_pos);
+	return;
+    }
+    f->ret_type = parse_type();
+    if (pos != name_pos)
+	parse_error("unsupported declaration of function %s", f->name);
+    if (f->ret_type.width == 0)
+	parse_error("void function");
+    pos++;
+    expect("(");
+
+    /* Parameters */
+    if (is_word("void") && tokens[pos+1].kind == T_OP
+	&& strcmp(tokens[pos+1].text, ")") == 0)
+	pos++;
+    while (!is_op(")")) {
+	if (f->nparams == MAX_PARAMS)
+	    parse_error("too many parameters");
+	f->param_types[f->nparams] = parse_type();
+	if (tokens[pos].kind != T_IDENT)
+	    parse_error("expected parameter name, found '%s'", tok_desc());
+	f->param_names[f->nparams++] = tokens[pos++].text;
+	if (!is_op(")"))
+	    expect(",");
+    }
+    pos++;
+    f->body = parse_stmt();
+    add_func(f);
+}
+
+/* Parse functions in text, which is modified during lexing */
+static void parse_text(char *text, char *name) {
+    fname = name;
+    macros = NULL;
+    tokenize(text);
+    pos = 0;
+    while (tokens[pos].kind != T_EOF)
+	parse_external();
+}
+
+int bv_parse_file(char *file_name) {
+    FILE *fp = fopen(file_name, "r");
+    char *text;
+    long len;
+
+    if (!fp)
+	return 0;
+    fseek(fp, 0, SEEK_END);
+    len = ftell(fp);
+    rewind(fp);
+    text = bv_malloc(len + 1);
+    if (fread(text, 1, len, fp) != len) {
+	fclose(fp);
+	return 0;
+    }
+    fclose(fp);
+    text[len] = '\0';
+    parse_text(text, file_name);
+    return 1;
+}
+
+void bv_parse_text(char *text, char *name) {
+    parse_text(bv_strndup(text, strlen(text)), name);
+}
+
+func_ptr bv_find_func(char *name) {
+    func_ptr f;
+    for (f = funcs; f; f = f->next)
+	if (strcmp(f->name, name) == 0)
+	    return f;
+    return NULL;
+}
+
+char *bv_func_error(func_ptr f) {
+    return f->error;
+}
+
+int bv_func_nparams(func_ptr f) {
+    return f->nparams;
+}
+
+ctype_t bv_func_param_type(func_ptr f, int i) {
+    return f->param_types[i];
+}
+
+/************
+ * Evaluator
+ ************/
+
+/*
+ * Statements are executed under a guard bit, which is true for the
+ * executions that reach them.  Every assignment becomes a multiplexer
+ * choosing between the new and the old value of the variable,
+ * depending on the guard.  Both branches of an if are executed, with
+ * guards for the condition and its complement.  Executions that have
+ * returned, or are leaving a loop or switch, are tracked with bits so
+ * that later statements don't affect them.
+ */
+
+static bit_ops_t *ops;
+static jmp_buf eval_env;
+static char eval_msg[MAX_MSG];
+static char *eval_file;
+static int call_depth;
+
+/* Variables in scope, most recent first */
+typedef struct VAR_ELE var_ele, *var_ptr;
+struct VAR_ELE {
+    char *name;
+    bv_t val;
+    var_ptr next;
+};
+
+static var_ptr env = NULL;
+
+/* Control state of function being evaluated */
+static int ret_bit, brk_bit, cont_bit;
+static bv_t ret_val;
+
+static void eval_error(int line, char *fmt, ...) {
+    va_list ap;
+    int len;
+    len = snprintf(eval_msg, MAX_MSG, "%s:%d: ", eval_file, line);
+    va_start(ap, fmt);
+    vsnprintf(eval_msg + len, MAX_MSG - len, fmt, ap);
+    va_end(ap);
+    longjmp(eval_env, 1);
+}
+
+/* Remove variables declared since env was saved */
+static void pop_env(var_ptr saved) {
+    while (env != saved) {
+	var_ptr v = env;
+	env = v->next;
+	free(v);
+    }
+}
+
+static var_ptr find_var(char *name, int line) {
+    var_ptr v;
+    for (v = env; v; v = v->next)
+	if (strcmp(v->name, name) == 0)
+	    return v;
+    eval_error(line, "undefined variable '%s'", name);
+    return NULL;
+}
+
+void bv_const(bit_ops_t *o, ctype_t type, long long val, bv_t *r) {
+    int i;
+    r->type = type;
+    for (i = 0; i < type.width; i++)
+	r->bits[i] = (val >> i) & 1 ? o->one : o->zero;
+}
+
+/* Convert a to type t.  r may be the same as a */
+static void convert(bv_t *a, ctype_t t, bv_t *r) {
+    int fill = a->type.is_signed ? a->bits[a->type.width-1] : ops->zero;
+    int i;
+    for (i = a->type.width; i < t.width; i++)
+	r->bits[i] = fill;
+    for (i = 0; i < t.width && i < a->type.width; i++)
+	r->bits[i] = a->bits[i];
+    r->type = t;
+}
+
+/* Integer promotion */
+static void promote(bv_t *a) {
+    if (a->type.width < 32)
+	convert(a, int_type, a);
+}
+
+/* Usual arithmetic conversions */
+static void arith_conv(bv_t *a, bv_t *b) {
+    ctype_t t;
+    promote(a);
+    promote(b);
+    if (a->type.width != b->type.width)
+	t = a->type.width > b->type.width ? a->type : b->type;
+    else {
+	t.width = a->type.width;
+	t.is_signed = a->type.is_signed && b->type.is_signed;
+    }
+    convert(a, t, a);
+    convert(b, t, b);
+}
+
+/* Boolean value as int */
+static void bool_val(int bit, bv_t *r) {
+    bv_const(ops, int_type, 0, r);
+    r->bits[0] = bit;
+}
+
+static int nonzero(bv_t *a) {
+    int bit = ops->zero;
+    int i;
+    for (i = 0; i < a->type.width; i++)
+	bit = ops->or(bit, a->bits[i]);
+    return bit;
+}
+
+static void mux(int c, bv_t *t, bv_t *e, bv_t *r) {
+    int i;
+    r->type = t->type;
+    for (i = 0; i < t->type.width; i++)
+	r->bits[i] = ops->ite(c, t->bits[i], e->bits[i]);
+}
+
+/* r = a + b + cin.  a, b, and r have the same type */
+static void add(bv_t *a, bv_t *b, int cin, bv_t *r) {
+    int carry = cin;
+    int i;
+    r->type = a->type;
+    for (i = 0; i < a->type.width; i++) {
+	int x = a->bits[i], y = b->bits[i];
+	int half = ops->xor(x, y);
+	r->bits[i] = ops->xor(half, carry);
+	carry = ops->ite(half, carry, x);
+    }
+}
+
+static void complement(bv_t *a, bv_t *r) {
+    int i;
+    r->type = a->type;
+    for (i = 0; i < a->type.width; i++)
+	r->bits[i] = ops->not(a->bits[i]);
+}
+
+static void multiply(bv_t *a, bv_t *b, bv_t *r) {
+    int w = a->type.width;
+    bv_t sum, part;
+    int i, j;
+    bv_const(ops, a->type, 0, &sum);
+    for (i = 0; i < w; i++) {
+	if (b->bits[i] == ops->zero)
+	    continue;
+	part.type = a->type;
+	for (j = 0; j < w; j++)
+	    part.bits[j] = j < i ? ops->zero : ops->and(b->bits[i], a->bits[j-i]);
+	add(&sum, &part, ops->zero, &sum);
+    }
+    *r = sum;
+}
+
+static int equal(bv_t *a, bv_t *b) {
+    int bit = ops->one;
+    int i;
+    for (i = 0; i < a->type.width; i++)
+	bit = ops->and(bit, ops->not(ops->xor(a->bits[i], b->bits[i])));
+    return bit;
+}
+
+/* a < b, where a and b have the same type */
+static int less(bv_t *a, bv_t *b) {
+    int w = a->type.width;
+    int lt = ops->zero;
+    int i;
+    for (i = 0; i < w - 1; i++)
+	lt = ops->ite(ops->xor(a->bits[i], b->bits[i]), b->bits[i], lt);
+    /* Sign bit counts against a signed value */
+    return ops->ite(ops->xor(a->bits[w-1], b->bits[w-1]),
+		    a->type.is_signed ? a->bits[w-1] : b->bits[w-1], lt);
+}
+
+int bv_less(bit_ops_t *o, bv_t *a, bv_t *b) {
+    ops = o;
+    return less(a, b);
+}
+
+/*
+ * Shift a by amount given by b.  As with x86 shift instructions,
+ * only the low-order bits of the amount are used
+ */
+static void shift(bv_t *a, bv_t *b, int left, bv_t *r) {
+    int w = a->type.width;
+    int fill = !left && a->type.is_signed ? a->bits[w-1] : ops->zero;
+    bv_t cur = *a;
+    int stage, i;
+
+    for (stage = 0; (1 << stage) < w; stage++) {
+	int d = 1 << stage;
+	int c = b->bits[stage];
+	bv_t next;
+	next.type = cur.type;
+	for (i = 0; i < w; i++) {
+	    int src = left ? i - d : i + d;
+	    int moved = src < 0 ? ops->zero : src >= w ? fill : cur.bits[src];
+	    next.bits[i] = ops->ite(c, moved, cur.bits[i]);
+	}
+	cur = next;
+    }
+    *r = cur;
+}
+
+/* Binary operators other than && and || */
+static void binary(char *op, bv_t *a, bv_t *b, bv_t *r, int line) {
+    bv_t x = *a, y = *b;
+    int i;
+
+    if (strcmp(op, "<<") == 0 || strcmp(op, ">>") == 0) {
+	promote(&x);
+	promote(&y);
+	shift(&x, &y, op[0] == '<', r);
+	return;
+    }
+    arith_conv(&x, &y);
+    r->type = x.type;
+    if (strcmp(op, "+") == 0)
+	add(&x, &y, ops->zero, r);
+    else if (strcmp(op, "-") == 0) {
+	complement(&y, &y);
+	add(&x, &y, ops->one, r);
+    } else if (strcmp(op, "*") == 0)
+	multiply(&x, &y, r);
+    else if (strcmp(op, "&") == 0)
+	for (i = 0; i < x.type.width; i++)
+	    r->bits[i] = ops->and(x.bits[i], y.bits[i]);
+    else if (strcmp(op, "|") == 0)
+	for (i = 0; i < x.type.width; i++)
+	    r->bits[i] = ops->or(x.bits[i], y.bits[i]);
+    else if (strcmp(op, "^") == 0)
+	for (i = 0; i < x.type.width; i++)
+	    r->bits[i] = ops->xor(x.bits[i], y.bits[i]);
+    else if (strcmp(op, "==") == 0)
+	bool_val(equal(&x, &y), r);
+    else if (strcmp(op, "!=") == 0)
+	bool_val(ops->not(equal(&x, &y)), r);
+    else if (strcmp(op, "<") == 0)
+	bool_val(less(&x, &y), r);
+    else if (strcmp(op, ">") == 0)
+	bool_val(less(&y, &x), r);
+    else if (strcmp(op, "<=") == 0)
+	bool_val(ops->not(less(&y, &x)), r);
+    else if (strcmp(op, ">=") == 0)
+	bool_val(ops->not(less(&x, &y)), r);
+    else
+	eval_error(line, "operator '%s' not supported", op);
+}
+
+/* Assign val to variable v for executions where guard holds */
+static void store(var_ptr v, bv_t *val, int guard) {
+    bv_t new;
+    int i;
+    convert(val, v->val.type, &new);
+    for (i = 0; i < new.type.width; i++)
+	v->val.bits[i] = guard == ops->one ? new.bits[i]
+	    : ops->ite(guard, new.bits[i], v->val.bits[i]);
+}
+
+static void exec(stmt_ptr s, int guard);
+static void eval_expr(expr_ptr e, int guard, bv_t *r);
+
+/* Evaluate function f on n arguments, for executions where guard holds */
+static void invoke(func_ptr f, bv_t args[], int n, int guard, bv_t *r,
+		   int line) {
+    var_ptr saved_env = env;
+    int saved_ret = ret_bit, saved_brk = brk_bit, saved_cont = cont_bit;
+    bv_t saved_val = ret_val;
+    char *saved_file = eval_file;
+    int i;
+
+    if (f->error)
+	eval_error(line, "can't call %s: %s", f->name, f->error);
+    if (n != f->nparams)
+	eval_error(line, "%s takes %d arguments", f->name, f->nparams);
+    if (call_depth == CALL_LIMIT)
+	eval_error(line, "calls nested too deeply");
+
+    /* Callee sees only its parameters */
+    env = NULL;
+    for (i = 0; i < n; i++) {
+	var_ptr v = bv_malloc(sizeof(var_ele));
+	v->name = f->param_names[i];
+	convert(&args[i], f->param_types[i], &v->val);
+	v->next = env;
+	env = v;
+    }
+    ret_bit = brk_bit = cont_bit = ops->zero;
+    bv_const(ops, f->ret_type, 0, &ret_val);
+    eval_file = f->file;
+    call_depth++;
+    exec(f->body, guard);
+    call_depth--;
+    *r = ret_val;
+
+    pop_env(NULL);
+    env = saved_env;
+    ret_bit = saved_ret;
+    brk_bit = saved_brk;
+    cont_bit = saved_cont;
+    ret_val = saved_val;
+    eval_file = saved_file;
+}
+
+static void call(expr_ptr e, int guard, bv_t *r) {
+    func_ptr f = bv_find_func(e->name);
+    bv_t args[MAX_PARAMS];
+    expr_ptr a;
+    int n = 0;
+
+    if (!f)
+	eval_error(e->line, "undefined function '%s'", e->name);
+    for (a = e->a; a; a = a->next) {
+	if (n == MAX_PARAMS)
+	    eval_error(e->line, "too many arguments to %s", e->name);
+	eval_expr(a, guard, &args[n++]);
+    }
+    invoke(f, args, n, guard, r, e->line);
+}
+
+static void eval_expr(expr_ptr e, int guard, bv_t *r) {
+    bv_t a, b;
+    var_ptr v;
+    int c;
+
+    switch (e->kind) {
+    case E_NUM:
+	bv_const(ops, e->type, e->val, r);
+	break;
+    case E_VAR:
+	*r = find_var(e->name, e->line)->val;
+	break;
+    case E_UNARY:
+	eval_expr(e->a, guard, r);
+	promote(r);
+	if (strcmp(e->op, "-") == 0) {
+	    bv_const(ops, r->type, 0, &a);
+	    binary("-", &a, r, r, e->line);
+	} else if (strcmp(e->op, "~") == 0)
+	    complement(r, r);
+	else if (strcmp(e->op, "!") == 0)
+	    bool_val(ops->not(nonzero(r)), r);
+	break;
+    case E_BINARY:
+	eval_expr(e->a, guard, &a);
+	if (strcmp(e->op, "&&") == 0 || strcmp(e->op, "||") == 0) {
+	    /* Right side is only evaluated when needed */
+	    int and = e->op[0] == '&';
+	    c = nonzero(&a);
+	    eval_expr(e->b, ops->and(guard, and ? c : ops->not(c)), &b);
+	    if (and)
+		bool_val(ops->and(c, nonzero(&b)), r);
+	    else
+		bool_val(ops->or(c, nonzero(&b)), r);
+	} else {
+	    eval_expr(e->b, guard, &b);
+	    binary(e->op, &a, &b, r, e->line);
+	}
+	break;
+    case E_COND:
+	eval_expr(e->a, guard, &a);
+	c = nonzero(&a);
+	eval_expr(e->b, ops->and(guard, c), &a);
+	eval_expr(e->c, ops->and(guard, ops->not(c)), &b);
+	arith_conv(&a, &b);
+	mux(c, &a, &b, r);
+	break;
+    case E_ASSIGN:
+	v = find_var(e->a->name, e->line);
+	eval_expr(e->b, guard, &b);
+	if (strcmp(e->op, "=") != 0) {
+	    /* Compound assignment.  Operator is all but the '=' */
+	    char op[4];
+	    strcpy(op, e->op);
+	    op[strlen(op)-1] = '\0';
+	    binary(op, &v->val, &b, &b, e->line);
+	}
+	store(v, &b, guard);
+	*r = v->val;
+	break;
+    case E_INCDEC:
+	if (e->a->kind != E_VAR)
+	    eval_error(e->line, "can only apply '%s' to variables", e->op);
+	v = find_var(e->a->name, e->line);
+	a = v->val;
+	bv_const(ops, int_type, 1, &b);
+	binary(e->op[0] == '+' ? "+" : "-", &a, &b, &b, e->line);
+	store(v, &b, guard);
+	*r = e->post ? a : v->val;
+	break;
+    case E_CAST:
+	eval_expr(e->a, guard, r);
+	if (e->type.width == 0)
+	    bv_const(ops, int_type, 0, r);
+	else
+	    convert(r, e->type, r);
+	break;
+    case E_CALL:
+	call(e, guard, r);
+	break;
+    case E_COMMA:
+	eval_expr(e->a, guard, &a);
+	eval_expr(e->b, guard, r);
+	break;
+    }
+    if (ops->observe)
+	ops->observe(e->site, r);
+}
+
+/* Guard restricted to executions that haven't returned or left a loop */
+static int active(int guard) {
+    int done = ops->or(ret_bit, ops->or(brk_bit, cont_bit));
+    return done == ops->zero ? guard : ops->and(guard, ops->not(done));
+}
+
+static void exec_loop(stmt_ptr s, int guard) {
+    int saved_brk = brk_bit, saved_cont = cont_bit;
+    int live = ops->one;        /* Executions still in loop */
+    int iter, g;
+    bv_t c;
+
+    brk_bit = cont_bit = ops->zero;
+    for (iter = 0; ; iter++) {
+	if ((g = active(ops->and(guard, live))) == ops->zero)
+	    break;
+	if (iter == LOOP_LIMIT)
+	    eval_error(s->line, "loop did not finish after %d iterations",
+		       LOOP_LIMIT);
+	if (s->kind == S_FOR && s->e) {
+	    eval_expr(s->e, g, &c);
+	    live = ops->and(live, nonzero(&c));
+	    if ((g = active(ops->and(guard, live))) == ops->zero)
+		break;
+	}
+	exec(s->body, g);
+	cont_bit = ops->zero;
+	g = active(ops->and(guard, live));
+	if (s->kind == S_FOR && s->step)
+	    eval_expr(s->step, g, &c);
+	if (s->kind == S_DO) {
+	    eval_expr(s->e, g, &c);
+	    live = ops->and(live, nonzero(&c));
+	}
+    }
+    brk_bit = saved_brk;
+    cont_bit = saved_cont;
+}
+
+static void exec(stmt_ptr s, int guard) {
+    var_ptr saved_env = env;
+    int g = active(guard);
+    stmt_ptr t;
+    bv_t v, c;
+
+    if (g == ops->zero && s->kind != S_DECLS)
+	return;
+    switch (s->kind) {
+    case S_EMPTY:
+	break;
+    case S_EXPR:
+	if (s->e)
+	    eval_expr(s->e, g, &v);
+	break;
+    case S_DECLS:
+	for (t = s->body; t; t = t->next) {
+	    var_ptr nv = bv_malloc(sizeof(var_ele));
+	    nv->name = t->name;
+	    if (t->e) {
+		eval_expr(t->e, g, &v);
+		convert(&v, t->type, &nv->val);
+	    } else
+		bv_const(ops, t->type, 0, &nv->val);
+	    nv->next = env;
+	    env = nv;
+	}
+	/* Variables stay in scope until end of enclosing block */
+	return;
+    case S_BLOCK:
+	for (t = s->body; t; t = t->next)
+	    exec(t, guard);
+	break;
+    case S_IF:
+	eval_expr(s->e, g, &c);
+	{
+	    int cond = nonzero(&c);
+	    exec(s->body, ops->and(g, cond));
+	    if (s->other)
+		exec(s->other, ops->and(g, ops->not(cond)));
+	}
+	break;
+    case S_SWITCH:
+	{
+	    int saved_brk = brk_bit;
+	    int entered = ops->zero;
+	    int no_match = ops->one;
+	    eval_expr(s->e, g, &v);
+	    promote(&v);
+	    for (t = s->body->body; t; t = t->next)
+		if (t->kind == S_CASE) {
+		    eval_expr(t->e, g, &c);
+		    convert(&c, v.type, &c);
+		    no_match = ops->and(no_match, ops->not(equal(&v, &c)));
+		}
+	    brk_bit = ops->zero;
+	    for (t = s->body->body; t; t = t->next) {
+		if (t->kind == S_CASE) {
+		    eval_expr(t->e, g, &c);
+		    convert(&c, v.type, &c);
+		    entered = ops->or(entered, equal(&v, &c));
+		} else if (t->kind == S_DEFAULT)
+		    entered = ops->or(entered, no_match);
+		else
+		    exec(t, ops->and(g, entered));
+	    }
+	    brk_bit = saved_brk;
+	}
+	break;
+    case S_CASE:
+    case S_DEFAULT:
+	eval_error(s->line, "case label not directly in switch");
+	break;
+    case S_BREAK:
+	brk_bit = ops->or(brk_bit, g);
+	break;
+    case S_CONTINUE:
+	cont_bit = ops->or(cont_bit, g);
+	break;
+    case S_RETURN:
+	if (s->e) {
+	    eval_expr(s->e, g, &v);
+	    convert(&v, ret_val.type, &v);
+	    mux(g, &v, &ret_val, &ret_val);
+	}
+	ret_bit = ops->or(ret_bit, g);
+	break;
+    case S_FOR:
+    case S_DO:
+	if (s->init)
+	    exec(s->init, g);
+	exec_loop(s, g);
+	break;
+    }
+    pop_env(saved_env);
+}
+
+char *bv_eval_func(func_ptr f, bv_t args[], bit_ops_t *o, bv_t *result) {
+    if (f->error)
+	return f->error;
+    ops = o;
+    env = NULL;
+    call_depth = 0;
+    eval_file = f->file;
+    ret_bit = brk_bit = cont_bit = ops->zero;
+    if (setjmp(eval_env)) {
+	env = NULL;
+	return eval_msg;
+    }
+    invoke(f, args, f->nparams, ops->one, result, 0);
+    return NULL;
+}
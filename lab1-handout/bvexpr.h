@@ -0,0 +1,88 @@
+/*
+ * CS 208 Lab 1: Data Lab
+ *
+ * bvexpr.h - Parse C functions and evaluate them symbolically, as
+ * vectors of bits
+ *
+ * The parser handles the subset of C used by puzzle solutions and
+ * their reference functions: integer types, local variables, the usual
+ * operators (other than / and %), if, switch, loops, and calls of
+ * other functions in the same files.  A function it can't handle gets
+ * an error message, and parsing resumes after its body.
+ *
+ * Evaluation works on bits supplied by a backend (BDD nodes, SAT
+ * literals), so the same code builds the logic of a function for any
+ * kind of solver.
+ */
+
+/* Integer type: width in bits and signedness */
+typedef struct {
+    int width;
+    int is_signed;
+} ctype_t;
+
+/* Maximum width of any value */
+#define BV_MAX_WIDTH 64
+
+/* Bit vector.  bits[0] is the least significant bit */
+typedef struct {
+    ctype_t type;
+    int bits[BV_MAX_WIDTH];
+} bv_t;
+
+/*
+ * Operations on single bits, supplied by the backend.  Bits are
+ * represented by integer handles, with zero and one being the
+ * constants.  Loops are unrolled until their condition becomes the
+ * constant zero, so backends should simplify operations on constants.
+ * If observe is set, it is called with the value of every expression
+ * evaluated, and a number identifying the expression in the source.
+ */
+typedef struct {
+    int zero, one;
+    int (*not)(int a);
+    int (*and)(int a, int b);
+    int (*or)(int a, int b);
+    int (*xor)(int a, int b);
+    int (*ite)(int i, int t, int e);
+    void (*observe)(int site, bv_t *v);
+} bit_ops_t;
+
+/* Information about parsed function */
+typedef struct FUNC_ELE func_ele, *func_ptr;
+
+/*
+ * Parse functions defined in file.  Return 0 if the file could not be
+ * read.  Errors within individual functions are recorded with the
+ * function.
+ */
+int bv_parse_file(char *fname);
+
+/* Parse functions defined in text, reporting errors as if it came
+   from a file with the given name */
+void bv_parse_text(char *text, char *name);
+
+/* Find function by name.  Return NULL if not defined */
+func_ptr bv_find_func(char *name);
+
+/* Error message from parsing function, or NULL if it parsed */
+char *bv_func_error(func_ptr f);
+
+/* Number of parameters */
+int bv_func_nparams(func_ptr f);
+
+/* Type of parameter i */
+ctype_t bv_func_param_type(func_ptr f, int i);
+
+/*
+ * Evaluate function f on args, building logic with ops.  Store
+ * return value in result.  Return NULL if successful, or else an
+ * error message.
+ */
+char *bv_eval_func(func_ptr f, bv_t args[], bit_ops_t *ops, bv_t *result);
+
+/* Bit vector for constant val */
+void bv_const(bit_ops_t *ops, ctype_t type, long long val, bv_t *r);
+
+/* Bit that is set when a < b, comparing as type of a */
+int bv_less(bit_ops_t *ops, bv_t *a, bv_t *b);
@@ -54,7 +54,7 @@ test_rec test_set[] = {
   {{TMin, TMax},{TMin,TMax},{TMin,TMax}}},
  {"bitAnd", (funct_t) bitAnd, (funct_t) test_bitAnd, 2, "| ~", 8, 5,
   {{TMin, TMax},{TMin,TMax},{TMin,TMax}}},
- {"conditional", (funct_t) conditional, (funct_t) test_conditional, 3, "! ~ & ^ | << >>", 16, 5,
+ {"conditional", (funct_t) conditional, (funct_t) test_conditional, 3, "! ~ & ^ | + << >>", 16, 5,
   {{TMin, TMax},{TMin,TMax},{TMin,TMax}}},
  {"logicalNeg", (funct_t) logicalNeg, (funct_t) test_logicalNeg, 1,
     "~ & ^ | + << >>", 12, 5,
@@ -66,6 +66,18 @@ test_rec test_set[] = {
   {{-TMax, TMax},{TMin,TMax},{TMin,TMax}}},
  {"isPower2", (funct_t) isPower2, (funct_t) test_isPower2, 1, "! ~ & ^ | + << >>", 20, 1,
   {{TMin, TMax},{TMin,TMax},{TMin,TMax}}},
+ {"floatNegate", (funct_t) floatNegate, (funct_t) test_floatNegate, 1,
+    "$", 10, 2,
+     {{1, 1},{1,1},{1,1}}},
+ {"floatScale2", (funct_t) floatScale2, (funct_t) test_floatScale2, 1,
+    "$", 30, 4,
+     {{1, 1},{1,1},{1,1}}},
+ {"floatInt2Float", (funct_t) floatInt2Float, (funct_t) test_floatInt2Float, 1,
+    "$", 30, 4,
+     {{TMin, TMax},{TMin,TMax},{TMin,TMax}}},
+ {"floatFloat2Int", (funct_t) floatFloat2Int, (funct_t) test_floatFloat2Int, 1,
+    "$", 30, 4,
+     {{1, 1},{1,1},{1,1}}},
   {"", NULL, NULL, 0, "", 0, 0,
    {{0, 0},{0,0},{0,0}}}
 };
@@ -0,0 +1,111 @@
+/*
+ * CS 208 Lab 1: Data Lab
+ *
+ * dlcheck.c - Check bits.c against the coding rules, and count the
+ * operators in each function.
+ *
+ * A replacement for dlc that takes the same -e, -z, -Z, and -o
+ * options, and reports in the same form, with the allowed operators
+ * and operator limits of the puzzles read from decl.c.  As with dlc,
+ * the statements of a zapped function are replaced with one that
+ * returns a constant, keeping the declarations before them.  The
+ * lines are kept, so that line numbers in later messages still match
+ * the original file.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "rules.h"
+
+/*
+ * write_zapped - Write text to fname, with the bodies of the zapped
+ * functions replaced.  Return 0 if the file can't be written
+ */
+static int write_zapped(char *fname, char *text, rule_result_t *r, int n,
+			int flags) {
+    FILE *fp = fopen(fname, "w");
+    int pos = 0, i, k;
+
+    if (!fp)
+	return 0;
+    for (i = 0; i < n; i++) {
+	if (!rules_zapped(&r[i], flags))
+	    continue;
+	fwrite(text + pos, 1, r[i].zap_start - pos, fp);
+	fprintf(fp, "return 4L;");
+	for (k = r[i].zap_start; k < r[i].body_end; k++)
+	    if (text[k] == '\n')
+		putc('\n', fp);
+	pos = r[i].body_end;
+    }
+    fputs(text + pos, fp);
+    return fclose(fp) == 0;
+}
+
+static void usage(char *cmd) {
+    printf("Usage: %s [-hezZ] [-d <decl>] [-o <out>] [<file>]\n", cmd);
+    printf("  -d <decl> Read the puzzles from decl (default decl.c)\n");
+    printf("  -e        Print the operator count of each function\n");
+    printf("  -h        Print this message\n");
+    printf("  -o <out>  Write file with zapped functions to out\n");
+    printf("  -z        Zap functions that break the coding rules\n");
+    printf("  -Z        Like -z, but also zap functions with too many operators\n");
+    printf("  <file>    File to check (default bits.c)\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    char *decl_name = "decl.c", *out_name = NULL, *fname = "bits.c";
+    char *text;
+    rule_t *rules;
+    rule_result_t *results;
+    int flags = 0;
+    int c, n;
+
+    /* -W sets dlc's warning level, which doesn't apply here */
+    while ((c = getopt(argc, argv, "hd:eo:zZW:")) != -1)
+	switch (c) {
+	case 'd':
+	    decl_name = optarg;
+	    break;
+	case 'e':
+	    flags |= RULES_COUNT;
+	    break;
+	case 'o':
+	    out_name = optarg;
+	    break;
+	case 'z':
+	    flags |= RULES_ZAP;
+	    break;
+	case 'Z':
+	    flags |= RULES_ZAP_OPS;
+	    break;
+	case 'W':
+	    break;
+	default:
+	    usage(argv[0]);
+	}
+    if (optind < argc)
+	fname = argv[optind];
+
+    rules = rules_read_decl(decl_name);
+    if (!rules) {
+	printf("%s: Couldn't read the puzzles from %s\n", argv[0], decl_name);
+	exit(1);
+    }
+    text = rules_read_file(fname);
+    if (!text) {
+	printf("%s: Couldn't read %s\n", argv[0], fname);
+	exit(1);
+    }
+    n = rules_check(text, fname, rules, flags, stdout, &results);
+    if (n < 0)
+	exit(1);
+    if (out_name && !write_zapped(out_name, text, results, n, flags)) {
+	printf("%s: Couldn't write %s\n", argv[0], out_name);
+	exit(1);
+    }
+    return 0;
+}
@@ -8,12 +8,15 @@
 # Note: The driver can use either btest or the BDD checker to check
 # puzzles for correctness. This version of the lab uses btest, which
 # has been extended to do better testing of both integer and
-# floating-point puzzles.
+# floating-point puzzles. The BDD checker (bddcheck) proves integer
+# puzzles correct for every argument, instead of testing a sample,
+# and tests floating-point puzzles on every argument.
 #
 #######################################################################
 
 use strict 'vars';
 use Getopt::Std;
+use JSON::PP;
 
 use lib ".";
 use Driverlib;
@@ -21,6 +24,14 @@ use Driverlib;
 # Set to 1 to use btest, 0 to use the BDD checker.
 my $USE_BTEST = 1;
 
+# Set to 1 to check the coding rules with dlcheck, 0 to use dlc.
+# btest can run the dlcheck rules itself, so with both set, btest is
+# built once and grades everything in one run (btest -G), rather than
+# being built and run for each zapped version of bits.c.  dlc stays
+# the default until dlcheck has been checked against it on more real
+# submissions; make testrules compares the two.
+my $USE_DLCHECK = 0;
+
 # Generic settings
 $| = 1;      # Flush stdout each time
 umask(0077); # Files created by the user in tmp readable only by that user
@@ -73,6 +84,8 @@ my $name;
 my $msg;
 my $nickname;
 my $autoresult;
+my $grades;
+my $puzzle;
 
 my %puzzle_c_points;
 my %puzzle_c_rating;
@@ -123,15 +136,23 @@ use strict 'vars';
 # Compute the correctness and performance scores
 ################################################
 
-# Make sure that an executable dlc (data lab compiler) exists
-(-e "./dlc" and -x "./dlc")
-    or  die "$0: ERROR: No executable dlc binary.\n";
+# Make sure that an executable dlc (data lab compiler) exists, or the
+# source of dlcheck
+if ($USE_DLCHECK) {
+    (-e "./dlcheck.c" and -e "./rules.c")
+	or  die "$0: ERROR: No source for dlcheck.\n";
+}
+else {
+    (-e "./dlc" and -x "./dlc")
+	or  die "$0: ERROR: No executable dlc binary.\n";
+}
+my $dlc = $USE_DLCHECK ? "./dlcheck" : "./dlc";
 
 
-# If using the bdd checker, then make sure it exists
+# If using the bdd checker, then make sure its sources exist
 if (!$USE_BTEST) {
-    (-e "./bddcheck/cbit/cbit" and -x "./bddcheck/cbit/cbit")
-	or  die "$0: ERROR: No executable cbit binary.\n";
+    (-e "./bddcheck.c" and -e "./bvexpr.c" and -e "./bdd.c")
+	or  die "$0: ERROR: No source for the BDD checker.\n";
 }
 
 #
@@ -148,14 +169,14 @@ unless (system("cp $infile $tmpdir/bits.c") == 0) {
 
 # Copy the various autograding files to the scratch directory
 if ($USE_BTEST) {
-    $driverfiles = "Makefile dlc btest.c decl.c tests.c btest.h bits.h";
+    $driverfiles = "Makefile dlc dlcheck.c rules.c rules.h btest.c decl.c tests.c batch.c kernels.c genkernels.pl bvexpr.c btest.h bits.h bvexpr.h";
     unless (system("cp -r $driverfiles $tmpdir") == 0) {
 	clean($tmpdir);
 	die "$0: Could not copy autogradingfiles to $tmpdir.\n";
     }
 }
 else {
-    $driverfiles = "dlc tests.c bddcheck";
+    $driverfiles = "Makefile dlc dlcheck.c rules.c rules.h bddcheck.c bdd.c bdd.h sat.c sat.h bvexpr.c bvexpr.h decl.c tests.c batch.c kernels.c genkernels.pl btest.h bits.h";
     unless (system("cp -r $driverfiles $tmpdir") == 0) {
 	clean($tmpdir);
 	die "$0: Could not copy support files to $tmpdir.\n";
@@ -168,188 +189,244 @@ unless (chdir($tmpdir)) {
     die "$0: Could not change directory to $tmpdir.\n";
 }
 
-#
-# Generate a zapped (for coding rules) version of bits.c. In this
-# zapped version of bits.c, any functions with illegal operators are
-# transformed to have empty function bodies.
-#
-print "1. Running './dlc -z' to identify coding rules violations.\n";
-system("cp bits.c save-bits.c") == 0
-    or die "$0: ERROR: Could not create backup copy of bits.c. $diemsg\n";
-system("./dlc -z -o zap-bits.c bits.c") == 0
-    or die "$0: ERROR: zapped bits.c did not compile. $diemsg\n";
-
-#
-# Run btest or BDD checker to determine correctness score
-#
-if ($USE_BTEST) {
-    print "\n2. Compiling and running './btest -g' to determine correctness score.\n";
-    system("cp zap-bits.c bits.c");
-
-    # Compile btest
+if ($USE_BTEST && $USE_DLCHECK) {
+    #
+    # btest -G checks the coding rules, tests bits.c, and counts its
+    # operators in one run, so bits.c is only compiled once
+    #
+    print "1. Compiling and running './btest -G' to determine correctness and performance scores.\n";
     system("make btestexplicit") == 0
 	or die "$0: Could not make btest in $tmpdir. $diemsg\n";
-
-    # Run btest
-    $status = system("./btest -g > btest-correct.out 2>&1");
-    if ($status != 0) {
-	die "$0: ERROR: btest check failed. $diemsg\n";
-    }
-}
-else {
-    print "\n2. Running './bddcheck/check.pl -g' to determine correctness score.\n";
-    system("cp zap-bits.c bits.c");
-    $status = system("./bddcheck/check.pl -g > btest-correct.out 2>&1");
+    $status = system("./btest -G > btest-grade.json");
     if ($status != 0) {
-	die "$0: ERROR: BDD check failed. $diemsg\n";
+	die "$0: ERROR: btest grading failed. $diemsg\n";
     }
-}
-
-#
-# Run dlc to identify operator count violations.
-#
-print "\n3. Running './dlc -Z' to identify operator count violations.\n";
-system("./dlc -Z -o Zap-bits.c save-bits.c") == 0
-    or die "$0: ERROR: dlc unable to generated Zapped bits.c file.\n";
-
-#
-# Run btest or the bdd checker to compute performance score
-#
-if ($USE_BTEST) {
-    print "\n4. Compiling and running './btest -g -r 2' to determine performance score.\n";
-    system("cp Zap-bits.c bits.c");
 
-    # Compile btest
-    system("make btestexplicit") == 0
-	or die "$0: Could not make btest in $tmpdir. $diemsg\n";
-    print "\n";
-
-    # Run btest
-    $status = system("./btest -g -r 2 > btest-perf.out 2>&1");
-    if ($status != 0) {
-	die "$0: ERROR: Zapped btest failed. $diemsg\n";
+    #
+    # Collect the results for each puzzle
+    #
+    open(INFILE, "$tmpdir/btest-grade.json")
+	or die "$0: ERROR: could not open input file $tmpdir/btest-grade.json\n";
+    $grades = decode_json(join("", <INFILE>));
+    close(INFILE);
+
+    $puzzlecnt = 0;
+    foreach $puzzle (@{$grades->{puzzles}}) {
+	$name = $puzzle->{name};
+	$puzzle_c_points{$name} = $puzzle->{correctness};
+	$puzzle_c_rating{$name} = $puzzle->{rating};
+	$puzzle_c_errors{$name} = $puzzle->{errors};
+	$puzzle_p_points{$name} = $puzzle->{performance};
+	$puzzle_p_ops{$name} = $puzzle->{ops};
+	$puzzle_number{$name} = $puzzlecnt++;
     }
+    $total_c_points = $grades->{correctness};
+    $total_c_rating = $grades->{correctness_max};
+    $total_p_points = $grades->{performance};
+    $total_p_rating = $grades->{performance_max};
+    $tops = $grades->{ops};
 }
 else {
-    print "\n4. Running './bddcheck/check.pl -g -r 2' to determine performance score.\n";
-    system("cp Zap-bits.c bits.c");
-    $status = system("./bddcheck/check.pl -g -r 2 > btest-perf.out 2>&1");
-    if ($status != 0) {
-	die "$0: ERROR: Zapped bdd checker failed. $diemsg\n";
+    #
+    # Generate a zapped (for coding rules) version of bits.c. In this
+    # zapped version of bits.c, any functions with illegal operators are
+    # transformed to have empty function bodies.
+    #
+    if ($USE_DLCHECK) {
+	system("make dlcheck") == 0
+	    or die "$0: Could not make dlcheck in $tmpdir. $diemsg\n";
     }
-}
-
-#
-# Run dlc to get the operator counts on the zapped input file
-#
-print "\n5. Running './dlc -e' to get operator count of each function.\n";
-$status = system("./dlc -W1 -e zap-bits.c > dlc-opcount.out 2>&1");
-if ($status != 0) {
-    die "$0: ERROR: bits.c did not compile. $diemsg\n";
-}
-
-#################################################################
-# Collect the correctness and performance results for each puzzle
-#################################################################
-
-#
-# Collect the correctness results
-#
-%puzzle_c_points = (); # Correctness score computed by btest
-%puzzle_c_errors = (); # Correctness error discovered by btest
-%puzzle_c_rating = (); # Correctness puzzle rating (max points)
-
-$inpuzzles = 0;      # Becomes true when we start reading puzzle results
-$puzzlecnt = 0;      # Each puzzle gets a unique number
-$total_c_points = 0;
-$total_c_rating = 0;
-
-open(INFILE, "$tmpdir/btest-correct.out")
-    or die "$0: ERROR: could not open input file $tmpdir/btest-correct.out\n";
-
-while ($line = <INFILE>) {
-    chomp($line);
-
-    # Notice that we're ready to read the puzzle scores
-    if ($line =~ /^Score/) {
-	$inpuzzles = 1;
-	next;
+    print "1. Running '$dlc -z' to identify coding rules violations.\n";
+    system("cp bits.c save-bits.c") == 0
+	or die "$0: ERROR: Could not create backup copy of bits.c. $diemsg\n";
+    system("$dlc -z -o zap-bits.c bits.c") == 0
+	or die "$0: ERROR: zapped bits.c did not compile. $diemsg\n";
+
+    #
+    # Run btest or BDD checker to determine correctness score
+    #
+    if ($USE_BTEST) {
+	print "\n2. Compiling and running './btest -g' to determine correctness score.\n";
+	system("cp zap-bits.c bits.c");
+
+	# Compile btest
+	system("make btestexplicit") == 0
+	    or die "$0: Could not make btest in $tmpdir. $diemsg\n";
+
+	# Run btest
+	$status = system("./btest -g > btest-correct.out 2>&1");
+	if ($status != 0) {
+	    die "$0: ERROR: btest check failed. $diemsg\n";
+	}
     }
-
-    # Notice that we're through reading the puzzle scores
-    if ($line =~ /^Total/) {
-	$inpuzzles = 0;
-	next;
+    else {
+	print "\n2. Compiling and running './bddcheck -g' to determine correctness score.\n";
+	system("cp zap-bits.c bits.c");
+
+	# Compile the checker
+	system("make bddcheckexplicit") == 0
+	    or die "$0: Could not make bddcheck in $tmpdir. $diemsg\n";
+
+	# Run the checker
+	$status = system("./bddcheck -g > btest-correct.out 2>&1");
+	if ($status != 0) {
+	    die "$0: ERROR: BDD check failed. $diemsg\n";
+	}
     }
 
-    # Read and record a puzzle's name and score
-    if ($inpuzzles) {
-	($blank, $c_points, $c_rating, $c_errors, $name) = split(/\s+/, $line);
-	$puzzle_c_points{$name} = $c_points;
-	$puzzle_c_errors{$name} = $c_errors;
-	$puzzle_c_rating{$name} = $c_rating;
-	$puzzle_number{$name} = $puzzlecnt++;
-	$total_c_points += $c_points;
-	$total_c_rating += $c_rating;
+    #
+    # Run dlc to identify operator count violations.
+    #
+    print "\n3. Running '$dlc -Z' to identify operator count violations.\n";
+    system("$dlc -Z -o Zap-bits.c save-bits.c") == 0
+	or die "$0: ERROR: dlc unable to generated Zapped bits.c file.\n";
+
+    #
+    # Run btest or the bdd checker to compute performance score
+    #
+    if ($USE_BTEST) {
+	print "\n4. Compiling and running './btest -g -r 2' to determine performance score.\n";
+	system("cp Zap-bits.c bits.c");
+
+	# Compile btest
+	system("make btestexplicit") == 0
+	    or die "$0: Could not make btest in $tmpdir. $diemsg\n";
+	print "\n";
+
+	# Run btest
+	$status = system("./btest -g -r 2 > btest-perf.out 2>&1");
+	if ($status != 0) {
+	    die "$0: ERROR: Zapped btest failed. $diemsg\n";
+	}
     }
-
-}
-close(INFILE);
-
-#
-# Collect the performance results
-#
-%puzzle_p_points = (); # Performance points
-
-$inpuzzles = 0;       # Becomes true when we start reading puzzle results
-$total_p_points = 0;
-$total_p_rating = 0;
-
-open(INFILE, "$tmpdir/btest-perf.out")
-    or die "$0: ERROR: could not open input file $tmpdir/btest-perf.out\n";
-
-while ($line = <INFILE>) {
-    chomp($line);
-
-    # Notice that we're ready to read the puzzle scores
-    if ($line =~ /^Score/) {
-	$inpuzzles = 1;
-	next;
-    }
-
-    # Notice that we're through reading the puzzle scores
-    if ($line =~ /^Total/) {
-	$inpuzzles = 0;
-	next;
+    else {
+	print "\n4. Compiling and running './bddcheck -g -r 2' to determine performance score.\n";
+	system("cp Zap-bits.c bits.c");
+
+	# Compile the checker
+	system("make bddcheckexplicit") == 0
+	    or die "$0: Could not make bddcheck in $tmpdir. $diemsg\n";
+	print "\n";
+
+	# Run the checker
+	$status = system("./bddcheck -g -r 2 > btest-perf.out 2>&1");
+	if ($status != 0) {
+	    die "$0: ERROR: Zapped bdd checker failed. $diemsg\n";
+	}
     }
 
-    # Read and record a puzzle's name and score
-    if ($inpuzzles) {
-	($blank, $p_points, $p_rating, $p_errors, $name) = split(/\s+/, $line);
-	$puzzle_p_points{$name} = $p_points;
-	$total_p_points += $p_points;
-	$total_p_rating += $p_rating;
+    #
+    # Run dlc to get the operator counts on the zapped input file
+    #
+    print "\n5. Running '$dlc -e' to get operator count of each function.\n";
+    $status = system("$dlc -W1 -e zap-bits.c > dlc-opcount.out 2>&1");
+    if ($status != 0) {
+	die "$0: ERROR: bits.c did not compile. $diemsg\n";
     }
-}
-close(INFILE);
 
-#
-# Collect the operator counts generated by dlc
-#
-open(INFILE, "$tmpdir/dlc-opcount.out")
-    or die "$0: ERROR: could not open input file $tmpdir/dlc-opcount.out\n";
+    #################################################################
+    # Collect the correctness and performance results for each puzzle
+    #################################################################
+
+    #
+    # Collect the correctness results
+    #
+    %puzzle_c_points = (); # Correctness score computed by btest
+    %puzzle_c_errors = (); # Correctness error discovered by btest
+    %puzzle_c_rating = (); # Correctness puzzle rating (max points)
+
+    $inpuzzles = 0;      # Becomes true when we start reading puzzle results
+    $puzzlecnt = 0;      # Each puzzle gets a unique number
+    $total_c_points = 0;
+    $total_c_rating = 0;
+
+    open(INFILE, "$tmpdir/btest-correct.out")
+	or die "$0: ERROR: could not open input file $tmpdir/btest-correct.out\n";
+
+    while ($line = <INFILE>) {
+	chomp($line);
+
+	# Notice that we're ready to read the puzzle scores
+	if ($line =~ /^Score/) {
+	    $inpuzzles = 1;
+	    next;
+	}
+
+	# Notice that we're through reading the puzzle scores
+	if ($line =~ /^Total/) {
+	    $inpuzzles = 0;
+	    next;
+	}
+
+	# Read and record a puzzle's name and score
+	if ($inpuzzles) {
+	    ($blank, $c_points, $c_rating, $c_errors, $name) = split(/\s+/, $line);
+	    $puzzle_c_points{$name} = $c_points;
+	    $puzzle_c_errors{$name} = $c_errors;
+	    $puzzle_c_rating{$name} = $c_rating;
+	    $puzzle_number{$name} = $puzzlecnt++;
+	    $total_c_points += $c_points;
+	    $total_c_rating += $c_rating;
+	}
 
-$tops = 0;
-while ($line = <INFILE>) {
-    chomp($line);
-
-    if ($line =~ /(\d+) operators/) {
-	($foo, $foo, $foo, $name, $msg) = split(/:/, $line);
-	$puzzle_p_ops{$name} = $1;
-	$tops += $1;
     }
+    close(INFILE);
+
+    #
+    # Collect the performance results
+    #
+    %puzzle_p_points = (); # Performance points
+
+    $inpuzzles = 0;       # Becomes true when we start reading puzzle results
+    $total_p_points = 0;
+    $total_p_rating = 0;
+
+    open(INFILE, "$tmpdir/btest-perf.out")
+	or die "$0: ERROR: could not open input file $tmpdir/btest-perf.out\n";
+
+    while ($line = <INFILE>) {
+	chomp($line);
+
+	# Notice that we're ready to read the puzzle scores
+	if ($line =~ /^Score/) {
+	    $inpuzzles = 1;
+	    next;
+	}
+
+	# Notice that we're through reading the puzzle scores
+	if ($line =~ /^Total/) {
+	    $inpuzzles = 0;
+	    next;
+	}
+
+	# Read and record a puzzle's name and score
+	if ($inpuzzles) {
+	    ($blank, $p_points, $p_rating, $p_errors, $name) = split(/\s+/, $line);
+	    $puzzle_p_points{$name} = $p_points;
+	    $total_p_points += $p_points;
+	    $total_p_rating += $p_rating;
+	}
+    }
+    close(INFILE);
+
+    #
+    # Collect the operator counts generated by dlc
+    #
+    open(INFILE, "$tmpdir/dlc-opcount.out")
+	or die "$0: ERROR: could not open input file $tmpdir/dlc-opcount.out\n";
+
+    $tops = 0;
+    while ($line = <INFILE>) {
+	chomp($line);
+
+	if ($line =~ /(\d+) operators/) {
+	    ($foo, $foo, $foo, $name, $msg) = split(/:/, $line);
+	    $puzzle_p_ops{$name} = $1;
+	    $tops += $1;
+	}
+    }
+    close(INFILE);
 }
-close(INFILE);
 
 #
 # Print a table of results sorted by puzzle number
@@ -2,6 +2,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include "readvals.h"
 float strtof(const char *nptr, char **endptr);
 
 #define FLOAT_SIZE 32
@@ -11,6 +13,15 @@ float strtof(const char *nptr, char **endptr);
 #define FRAC_MASK ((1<<FRAC_SIZE)-1)
 #define EXP_MASK ((1<<EXP_SIZE)-1)
 
+/* Output format */
+#define SHOW_TEXT  0   /* A paragraph per value */
+#define SHOW_TABLE 1   /* A row per value, separated by tabs */
+#define SHOW_CSV   2   /* A row per value, separated by commas */
+
+static int format = SHOW_TEXT;
+static char *in_name = NULL;
+static char *cmd;
+
 /* Floating point helpers */
 unsigned f2u(float f)
 {
@@ -78,6 +89,33 @@ void show_float(unsigned uf)
   }
 }
 
+/* Show a value as a row of the table, after the value as given.  The
+   mantissa and power are left empty for infinity and NaN */
+void show_float_row(char *sval, unsigned uf)
+{
+  char sep = format == SHOW_CSV ? ',' : '\t';
+  unsigned exp = get_exp(uf);
+  unsigned frac = get_frac(uf);
+  unsigned sign = get_sign(uf);
+
+  printf("%s%c0x%.8x%c%.10g%c%x%c0x%.2x%c0x%.6x%c",
+	 sval, sep, uf, sep, u2f(uf), sep, sign, sep, exp, sep, frac, sep);
+  if (exp == EXP_MASK) {
+    if (frac == 0)
+      printf("%cInfinity%c%c\n", sign ? '-' : '+', sep, sep);
+    else
+      printf("Not-A-Number%c%c\n", sep, sep);
+  } else {
+    int denorm = (exp == 0);
+    int uexp = denorm ? 1-BIAS : exp - BIAS;
+    int mantissa = denorm ? frac : frac + (1<<FRAC_SIZE);
+    float fman = (float) mantissa / (float) (1<<FRAC_SIZE);
+    printf("%s%c%c%.10f%c%d\n",
+	   denorm ? "Denormalized" : "Normalized", sep,
+	   sign ? '-' : '+', fman, sep, uexp);
+  }
+}
+
 /* Extract hex/decimal/or float value from string */
 static int get_num_val(char *sval, unsigned *valp) {
   char *endp;
@@ -114,7 +152,8 @@ static int get_num_val(char *sval, unsigned *valp) {
     long long int llval = strtoll(sval, &endp, 0);
     long long int upperbits = llval >> 31;
     /* will give -1 for negative, 0 or 1 for positive */
-    if (valp && (upperbits == 0 || upperbits == -1 || upperbits == 1)) {
+    if (valp && !*endp
+	&& (upperbits == 0 || upperbits == -1 || upperbits == 1)) {
       *valp = (unsigned) llval;
       return 1;
     }
@@ -124,26 +163,71 @@ static int get_num_val(char *sval, unsigned *valp) {
 
 
 void usage(char *fname) {
-  printf("Usage: %s val1 val2 ...\n", fname);
+  printf("Usage: %s [-ct] [-i <file>] val1 val2 ...\n", fname);
   printf("Values may be given as hex patterns or as floating point numbers\n");
+  printf("  -c        Show a comma separated row per value\n");
+  printf("  -i <file> Also show each value in file, or stdin if file is -\n");
+  printf("  -t        Show a tab separated row per value\n");
   exit(0);
 }
 
-
-int main(int argc, char *argv[])
+/* Show the value in string sval, found on line of the input file, or
+   on the command line if line is 0.  An invalid value in a file, or
+   shown as a row, is reported to stderr and skipped, so that the rows
+   stay readable by other programs */
+void show_val(char *sval, long line)
 {
-  int i;
   unsigned uf;
-  if (argc < 2)
-    usage(argv[0]);
-  for (i = 1; i < argc; i++) {
-    char *sval = argv[i];
-    if (get_num_val(sval, &uf)) {
-      show_float(uf);
+  if (!get_num_val(sval, &uf)) {
+    if (line > 0) {
+      fprintf(stderr, "%s:%ld: Invalid 32-bit number: '%s'\n",
+	      in_name, line, sval);
+    } else if (format != SHOW_TEXT) {
+      fprintf(stderr, "Invalid 32-bit number: '%s'\n", sval);
     } else {
       printf("Invalid 32-bit number: '%s'\n", sval);
-      usage(argv[0]);
+      usage(cmd);
     }
+  } else if (format == SHOW_TEXT) {
+    show_float(uf);
+  } else {
+    show_float_row(sval, uf);
+  }
+}
+
+
+int main(int argc, char *argv[])
+{
+  int i;
+  cmd = argv[0];
+  /* Not getopt, which would take negative values for options */
+  for (i = 1; i < argc && argv[i][0] == '-'
+	 && argv[i][1] >= 'a' && argv[i][1] <= 'z'; i++) {
+    if (!strcmp(argv[i], "-c"))
+      format = SHOW_CSV;
+    else if (!strcmp(argv[i], "-t"))
+      format = SHOW_TABLE;
+    else if (!strcmp(argv[i], "-i") && i + 1 < argc)
+      in_name = argv[++i];
+    else
+      usage(argv[0]);
+  }
+  if (i >= argc && !in_name)
+    usage(argv[0]);
+  /* Rows can be many, so fill a large buffer before writing */
+  if (format != SHOW_TEXT) {
+    setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+    if (format == SHOW_CSV)
+      printf("Value,Hex,Float,Sign,Exponent,Fraction,Kind,Mantissa,Power\n");
+    else
+      printf("Value\tHex\tFloat\tSign\tExponent\tFraction\tKind\tMantissa\tPower\n");
+  }
+  for (; i < argc; i++)
+    show_val(argv[i], 0);
+  if (in_name && !read_values(in_name, show_val)) {
+    fflush(stdout);
+    fprintf(stderr, "%s: Couldn't read %s\n", argv[0], in_name);
+    return 1;
   }
   return 0;
 }
@@ -0,0 +1,87 @@
+#!/usr/bin/perl
+#######################################################################
+# genkernels.pl - Generate the batch kernels used by btest
+#
+# Reads the test_set table in decl.c, and writes a kernel for each
+# puzzle, specialized to its number of arguments and to its solution
+# and reference functions, followed by the batch_set table that
+# btest uses to find the kernels.  batch.c includes the output, so
+# that the compiler can inline the reference function into the kernel
+# loops.  The solution is called, since bits.c is compiled on its own.
+#
+# Usage: genkernels.pl [decl.c] > kernels.c
+#
+#######################################################################
+
+use strict 'vars';
+
+my $infile = $ARGV[0] || "decl.c";
+my $text;
+my @puzzles;
+
+open(my $in, "<", $infile)
+    or die "$0: Could not open $infile\n";
+{
+    local $/;
+    $text = <$in>;
+}
+close($in);
+
+# Comments may contain anything, including braces
+$text =~ s|/\*.*?\*/||gs;
+
+# Each entry of the table has the form
+#   {"name", (funct_t) name, (funct_t) test_name, args, "ops", limit,
+#    rating, {{min, max},{min, max},{min, max}}, width}
+# where the width is optional
+while ($text =~ /\{\s*"(\w+)"\s*,\s*\(funct_t\)\s*(\w+)\s*,\s*\(funct_t\)\s*(\w+)\s*,\s*(\d+)\s*,.*?\}\s*\}\s*(?:,\s*(\d+)\s*)?\}/gs) {
+    push(@puzzles, {name => $1, solution => $2, reference => $3,
+                    args => $4, width => $5 || 32});
+}
+@puzzles > 0
+    or die "$0: No puzzles found in $infile\n";
+
+print <<'END';
+/*
+ * CS 208 Lab 1: Data Lab
+ *
+ * kernels.c - Batch kernels for the puzzles, included by batch.c.
+ *
+ * Generated by genkernels.pl from decl.c.  Do not edit.
+ */
+
+END
+
+foreach my $p (@puzzles) {
+    my @fixed = ("a1", "a2");
+    my $args = $p->{args};
+    my $call_args;
+
+    # Functions without arguments are never batched, and the batches
+    # hold values of at most 32 bits
+    next if $args < 1 || $args > 3 || $p->{width} > 32;
+    $call_args = join(", ", @fixed[0 .. $args - 2], "x[k]");
+    print <<END;
+static int batch_$p->{name}(int a1, int a2, const int x[], int n)
+{
+    int k, bad = 0;
+    for (k = 0; k < n; k++)
+	bad |= $p->{solution}($call_args) ^ $p->{reference}($call_args);
+    if (!bad)
+	return -1;
+    for (k = 0; k < n; k++)
+	if ($p->{solution}($call_args) != $p->{reference}($call_args))
+	    return k;
+    return -1;
+}
+
+END
+}
+
+print "batch_rec batch_set[] = {\n";
+foreach my $p (@puzzles) {
+    next if $p->{args} < 1 || $p->{args} > 3 || $p->{width} > 32;
+    print "    {\"$p->{name}\", batch_$p->{name}},\n";
+}
+print "    {NULL, NULL}\n";
+print "};\n";
@@ -1,6 +1,16 @@
 /* Display value of fixed point numbers */
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include "readvals.h"
+
+/* Output format */
+#define SHOW_TEXT  0   /* A sentence per value */
+#define SHOW_TABLE 1   /* A row per value, separated by tabs */
+#define SHOW_CSV   2   /* A row per value, separated by commas */
+
+static int format = SHOW_TEXT;
+static char *in_name = NULL;
 
 /* Extract hex/decimal/or float value from string */
 static int get_num_val(char *sval, unsigned *valp) {
@@ -33,7 +43,8 @@ static int get_num_val(char *sval, unsigned *valp) {
     long long int llval = strtoll(sval, &endp, 0);
     long long int upperbits = llval >> 31;
     /* will give -1 for negative, 0 or 1 for positive */
-    if (valp && (upperbits == 0 || upperbits == -1 || upperbits == 1)) {
+    if (valp && !*endp
+	&& (upperbits == 0 || upperbits == -1 || upperbits == 1)) {
       *valp = (unsigned) llval;
       return 1;
     }
@@ -48,25 +59,75 @@ void show_int(unsigned uf)
 }
 
 
+/* Show a value as a row of the table, after the value as given */
+void show_int_row(char *sval, unsigned uf)
+{
+  char sep = format == SHOW_CSV ? ',' : '\t';
+  printf("%s%c0x%.8x%c%d%c%u\n", sval, sep, uf, sep, (int) uf, sep, uf);
+}
+
+/* Show the value in string sval, found on line of the input file, or
+   on the command line if line is 0.  Errors go to stderr, except in
+   the text shown for command line values, so that the rows stay
+   readable by other programs */
+void show_val(char *sval, long line)
+{
+  unsigned uf;
+  if (!get_num_val(sval, &uf)) {
+    if (line > 0)
+      fprintf(stderr, "%s:%ld: Cannot convert '%s' to 32-bit number\n",
+	      in_name, line, sval);
+    else if (format != SHOW_TEXT)
+      fprintf(stderr, "Cannot convert '%s' to 32-bit number\n", sval);
+    else
+      printf("Cannot convert '%s' to 32-bit number\n", sval);
+  } else if (format == SHOW_TEXT) {
+    show_int(uf);
+  } else {
+    show_int_row(sval, uf);
+  }
+}
+
 void usage(char *fname) {
-  printf("Usage: %s val1 val2 ...\n", fname);
+  printf("Usage: %s [-ct] [-i <file>] val1 val2 ...\n", fname);
   printf("Values may be given in hex or decimal\n");
+  printf("  -c        Show a comma separated row per value\n");
+  printf("  -i <file> Also show each value in file, or stdin if file is -\n");
+  printf("  -t        Show a tab separated row per value\n");
   exit(0);
 }
 
 int main(int argc, char *argv[])
 {
   int i;
-  unsigned uf;
-  if (argc < 2)
+  /* Not getopt, which would take negative values for options */
+  for (i = 1; i < argc && argv[i][0] == '-'
+	 && argv[i][1] >= 'a' && argv[i][1] <= 'z'; i++) {
+    if (!strcmp(argv[i], "-c"))
+      format = SHOW_CSV;
+    else if (!strcmp(argv[i], "-t"))
+      format = SHOW_TABLE;
+    else if (!strcmp(argv[i], "-i") && i + 1 < argc)
+      in_name = argv[++i];
+    else
+      usage(argv[0]);
+  }
+  if (i >= argc && !in_name)
     usage(argv[0]);
-  for (i = 1; i < argc; i++) {
-    char *sval = argv[i];
-    if (get_num_val(sval, &uf)) {
-      show_int(uf);
-    } else {
-      printf("Cannot convert '%s' to 32-bit number\n", sval);
-    }
+  /* Rows can be many, so fill a large buffer before writing */
+  if (format != SHOW_TEXT) {
+    setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+    if (format == SHOW_CSV)
+      printf("Value,Hex,Signed,Unsigned\n");
+    else
+      printf("Value\tHex\tSigned\tUnsigned\n");
+  }
+  for (; i < argc; i++)
+    show_val(argv[i], 0);
+  if (in_name && !read_values(in_name, show_val)) {
+    fflush(stdout);
+    fprintf(stderr, "%s: Couldn't read %s\n", argv[0], in_name);
+    return 1;
   }
   return 0;
 }
@@ -0,0 +1,193 @@
+/*
+ * CS 208 Lab 1: Data Lab
+ *
+ * kernels.c - Batch kernels for the puzzles, included by batch.c.
+ *
+ * Generated by genkernels.pl from decl.c.  Do not edit.
+ */
+
+static int batch_sign(int a1, int a2, const int x[], int n)
+{
+    int k, bad = 0;
+    for (k = 0; k < n; k++)
+	bad |= sign(x[k]) ^ test_sign(x[k]);
+    if (!bad)
+	return -1;
+    for (k = 0; k < n; k++)
+	if (sign(x[k]) != test_sign(x[k]))
+	    return k;
+    return -1;
+}
+
+static int batch_getByte(int a1, int a2, const int x[], int n)
+{
+    int k, bad = 0;
+    for (k = 0; k < n; k++)
+	bad |= getByte(a1, x[k]) ^ test_getByte(a1, x[k]);
+    if (!bad)
+	return -1;
+    for (k = 0; k < n; k++)
+	if (getByte(a1, x[k]) != test_getByte(a1, x[k]))
+	    return k;
+    return -1;
+}
+
+static int batch_bitXor(int a1, int a2, const int x[], int n)
+{
+    int k, bad = 0;
+    for (k = 0; k < n; k++)
+	bad |= bitXor(a1, x[k]) ^ test_bitXor(a1, x[k]);
+    if (!bad)
+	return -1;
+    for (k = 0; k < n; k++)
+	if (bitXor(a1, x[k]) != test_bitXor(a1, x[k]))
+	    return k;
+    return -1;
+}
+
+static int batch_bitAnd(int a1, int a2, const int x[], int n)
+{
+    int k, bad = 0;
+    for (k = 0; k < n; k++)
+	bad |= bitAnd(a1, x[k]) ^ test_bitAnd(a1, x[k]);
+    if (!bad)
+	return -1;
+    for (k = 0; k < n; k++)
+	if (bitAnd(a1, x[k]) != test_bitAnd(a1, x[k]))
+	    return k;
+    return -1;
+}
+
+static int batch_conditional(int a1, int a2, const int x[], int n)
+{
+    int k, bad = 0;
+    for (k = 0; k < n; k++)
+	bad |= conditional(a1, a2, x[k]) ^ test_conditional(a1, a2, x[k]);
+    if (!bad)
+	return -1;
+    for (k = 0; k < n; k++)
+	if (conditional(a1, a2, x[k]) != test_conditional(a1, a2, x[k]))
+	    return k;
+    return -1;
+}
+
+static int batch_logicalNeg(int a1, int a2, const int x[], int n)
+{
+    int k, bad = 0;
+    for (k = 0; k < n; k++)
+	bad |= logicalNeg(x[k]) ^ test_logicalNeg(x[k]);
+    if (!bad)
+	return -1;
+    for (k = 0; k < n; k++)
+	if (logicalNeg(x[k]) != test_logicalNeg(x[k]))
+	    return k;
+    return -1;
+}
+
+static int batch_isLessOrEqual(int a1, int a2, const int x[], int n)
+{
+    int k, bad = 0;
+    for (k = 0; k < n; k++)
+	bad |= isLessOrEqual(a1, x[k]) ^ test_isLessOrEqual(a1, x[k]);
+    if (!bad)
+	return -1;
+    for (k = 0; k < n; k++)
+	if (isLessOrEqual(a1, x[k]) != test_isLessOrEqual(a1, x[k]))
+	    return k;
+    return -1;
+}
+
+static int batch_absVal(int a1, int a2, const int x[], int n)
+{
+    int k, bad = 0;
+    for (k = 0; k < n; k++)
+	bad |= absVal(x[k]) ^ test_absVal(x[k]);
+    if (!bad)
+	return -1;
+    for (k = 0; k < n; k++)
+	if (absVal(x[k]) != test_absVal(x[k]))
+	    return k;
+    return -1;
+}
+
+static int batch_isPower2(int a1, int a2, const int x[], int n)
+{
+    int k, bad = 0;
+    for (k = 0; k < n; k++)
+	bad |= isPower2(x[k]) ^ test_isPower2(x[k]);
+    if (!bad)
+	return -1;
+    for (k = 0; k < n; k++)
+	if (isPower2(x[k]) != test_isPower2(x[k]))
+	    return k;
+    return -1;
+}
+
+static int batch_floatNegate(int a1, int a2, const int x[], int n)
+{
+    int k, bad = 0;
+    for (k = 0; k < n; k++)
+	bad |= floatNegate(x[k]) ^ test_floatNegate(x[k]);
+    if (!bad)
+	return -1;
+    for (k = 0; k < n; k++)
+	if (floatNegate(x[k]) != test_floatNegate(x[k]))
+	    return k;
+    return -1;
+}
+
+static int batch_floatScale2(int a1, int a2, const int x[], int n)
+{
+    int k, bad = 0;
+    for (k = 0; k < n; k++)
+	bad |= floatScale2(x[k]) ^ test_floatScale2(x[k]);
+    if (!bad)
+	return -1;
+    for (k = 0; k < n; k++)
+	if (floatScale2(x[k]) != test_floatScale2(x[k]))
+	    return k;
+    return -1;
+}
+
+static int batch_floatInt2Float(int a1, int a2, const int x[], int n)
+{
+    int k, bad = 0;
+    for (k = 0; k < n; k++)
+	bad |= floatInt2Float(x[k]) ^ test_floatInt2Float(x[k]);
+    if (!bad)
+	return -1;
+    for (k = 0; k < n; k++)
+	if (floatInt2Float(x[k]) != test_floatInt2Float(x[k]))
+	    return k;
+    return -1;
+}
+
+static int batch_floatFloat2Int(int a1, int a2, const int x[], int n)
+{
+    int k, bad = 0;
+    for (k = 0; k < n; k++)
+	bad |= floatFloat2Int(x[k]) ^ test_floatFloat2Int(x[k]);
+    if (!bad)
+	return -1;
+    for (k = 0; k < n; k++)
+	if (floatFloat2Int(x[k]) != test_floatFloat2Int(x[k]))
+	    return k;
+    return -1;
+}
+
+batch_rec batch_set[] = {
+    {"sign", batch_sign},
+    {"getByte", batch_getByte},
+    {"bitXor", batch_bitXor},
+    {"bitAnd", batch_bitAnd},
+    {"conditional", batch_conditional},
+    {"logicalNeg", batch_logicalNeg},
+    {"isLessOrEqual", batch_isLessOrEqual},
+    {"absVal", batch_absVal},
+    {"isPower2", batch_isPower2},
+    {"floatNegate", batch_floatNegate},
+    {"floatScale2", batch_floatScale2},
+    {"floatInt2Float", batch_floatInt2Float},
+    {"floatFloat2Int", batch_floatFloat2Int},
+    {NULL, NULL}
+};
@@ -0,0 +1,102 @@
+/*
+ * CS 208 Lab 1: Data Lab
+ *
+ * readvals.c - Read the values for ishow and fshow from a file
+ */
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "readvals.h"
+
+/* Size of the blocks read from input that can't be mapped */
+#define BLOCK_SIZE (1 << 16)
+
+/* The value being read, which may span blocks */
+typedef struct {
+    char val[VAL_MAX + 4];
+    int len;
+    long line;
+    val_fn *fn;
+} scan_t;
+
+/*
+ * end_value - Pass on the value read so far, if there is one
+ */
+static void end_value(scan_t *s)
+{
+    if (s->len == 0)
+	return;
+    if (s->len > VAL_MAX)
+	strcpy(s->val + VAL_MAX, "...");
+    else
+	s->val[s->len] = '\0';
+    s->fn(s->val, s->line);
+    s->len = 0;
+}
+
+/*
+ * scan - Split the n characters at p into values
+ */
+static void scan(scan_t *s, char *p, size_t n)
+{
+    char *end = p + n;
+    char c;
+
+    for (; p < end; p++) {
+	c = *p;
+	if (c == ' ' || c == '\t' || c == ',' || c == '\r' || c == '\n') {
+	    end_value(s);
+	    if (c == '\n')
+		s->line++;
+	} else {
+	    if (s->len < VAL_MAX)
+		s->val[s->len] = c;
+	    /* Count past VAL_MAX, so that end_value knows to cut it */
+	    if (s->len <= VAL_MAX)
+		s->len++;
+	}
+    }
+}
+
+int read_values(char *fname, val_fn *fn)
+{
+    scan_t s;
+    struct stat st;
+    char buf[BLOCK_SIZE];
+    char *text;
+    ssize_t n;
+    int fd = 0;
+
+    s.len = 0;
+    s.line = 1;
+    s.fn = fn;
+    if (strcmp(fname, "-") != 0) {
+	fd = open(fname, O_RDONLY);
+	if (fd < 0)
+	    return 0;
+    }
+
+    /* A regular file can be scanned without copying it */
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+	text = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (text != MAP_FAILED) {
+	    madvise(text, st.st_size, MADV_SEQUENTIAL);
+	    scan(&s, text, st.st_size);
+	    end_value(&s);
+	    munmap(text, st.st_size);
+	    if (fd != 0)
+		close(fd);
+	    return 1;
+	}
+    }
+
+    while ((n = read(fd, buf, sizeof(buf))) > 0)
+	scan(&s, buf, n);
+    end_value(&s);
+    if (fd != 0)
+	close(fd);
+    return n == 0;
+}
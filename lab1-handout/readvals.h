@@ -0,0 +1,21 @@
+/*
+ * CS 208 Lab 1: Data Lab
+ *
+ * readvals.h - Read the values for ishow and fshow from a file
+ *
+ * Values are separated by white space or commas, so a column of
+ * numbers or a line of CSV both work.  A regular file is mapped into
+ * memory and scanned in place; other input, such as a pipe, is read
+ * in large blocks.
+ */
+
+/* Longest value passed on.  Longer ones are cut short and end in
+   "...", so they don't convert */
+#define VAL_MAX 64
+
+/* Called with each value, as a string, and the line it is on */
+typedef void val_fn(char *sval, long line);
+
+/* Call fn on each value in the file named fname, or in stdin if fname
+   is "-".  Return 0 if the file can't be read */
+int read_values(char *fname, val_fn *fn);
@@ -0,0 +1,935 @@
+/*
+ * CS 208 Lab 1: Data Lab
+ *
+ * rules.c - Check puzzle solutions against the coding rules, and count
+ * their operators, as dlc does
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include "rules.h"
+
+/*********
+ * Lexer
+ *********/
+
+#define T_EOF   0
+#define T_IDENT 1
+#define T_NUM   2       /* Integer constant */
+#define T_FLOAT 3       /* Floating point constant */
+#define T_QUOTE 4       /* Character or string constant */
+#define T_OP    5
+
+typedef struct {
+    int kind;
+    char *text;
+    int line;
+    int pos;            /* Offset in the source */
+} token_t;
+
+static token_t *tokens = NULL;
+static int ntokens = 0;
+static int alloc_tokens = 0;
+
+/* Macros defined by #define lines.  Their uses are replaced by their
+   bodies before checking, as the preprocessor does for dlc */
+typedef struct {
+    char *name;
+    int nparams;        /* Parameters, or -1 if it takes no arguments */
+    char **params;
+    token_t *body;
+    int nbody;
+    int first;          /* First token after the definition */
+} macro_t;
+
+static macro_t *macros = NULL;
+static int nmacros = 0;
+static int alloc_macros = 0;
+
+static void *rules_malloc(size_t size) {
+    void *p = calloc(1, size);
+    if (!p) {
+	printf("Couldn't allocate space for checking\n");
+	exit(1);
+    }
+    return p;
+}
+
+/* Make room for one more element in array *p of *alloc elements */
+static void grow(void **p, int n, int *alloc, size_t size) {
+    if (n < *alloc)
+	return;
+    *alloc = *alloc ? 2 * *alloc : 256;
+    *p = realloc(*p, *alloc * size);
+    if (!*p) {
+	printf("Couldn't allocate space for checking\n");
+	exit(1);
+    }
+}
+
+static char *rules_strndup(char *s, int len) {
+    char *r = rules_malloc(len + 1);
+    memcpy(r, s, len);
+    return r;
+}
+
+/* Operators, longest first so that the longest match is taken */
+static char *op_list[] = {
+    "<<=", ">>=", "...",
+    "<<", ">>", "<=", ">=", "==", "!=", "&&", "||", "++", "--", "->",
+    "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=",
+    "+", "-", "*", "/", "%", "<", ">", "=", "!", "~", "&", "|", "^",
+    "?", ":", ";", ",", "(", ")", "{", "}", "[", "]", ".",
+    NULL
+};
+
+/* Word of directive on line starting at s, or NULL if not a directive */
+static char *directive_word(char *s) {
+    while (*s == ' ' || *s == '\t')
+	s++;
+    if (*s != '#')
+	return NULL;
+    s++;
+    while (*s == ' ' || *s == '\t')
+	s++;
+    return s;
+}
+
+static int is_directive(char *word, char *name) {
+    int len = strlen(name);
+    return strncmp(word, name, len) == 0 && !isalnum((int) word[len]);
+}
+
+/* Skip to the end of the line at s, counting lines that end with a
+   backslash */
+static char *end_of_line(char *s, int *line) {
+    while (*s && *s != '\n') {
+	if (s[0] == '\\' && s[1] == '\n') {
+	    s++;
+	    (*line)++;
+	}
+	s++;
+    }
+    return s;
+}
+
+/* Skip lines of #if 0 group, starting at end of its #if line.
+   Return the end of the #else or #endif line that ends it */
+static char *skip_group(char *s, int *line) {
+    int depth = 0;
+    while (*s) {
+	char *word;
+	if (*s == '\n') {
+	    (*line)++;
+	    s++;
+	}
+	word = directive_word(s);
+	if (word) {
+	    if (is_directive(word, "if") || is_directive(word, "ifdef")
+		|| is_directive(word, "ifndef"))
+		depth++;
+	    else if (depth == 0 && (is_directive(word, "endif")
+				    || is_directive(word, "else")))
+		break;
+	    else if (is_directive(word, "endif"))
+		depth--;
+	}
+	s = end_of_line(s, line);
+    }
+    return end_of_line(s, line);
+}
+
+static char *lex_token(char *s, token_t *t);
+
+/* Split the body of a macro, from s to end, into the tokens of m */
+static void lex_body(macro_t *m, char *s, char *end) {
+    int alloc = 0;
+    token_t t;
+
+    while (s < end) {
+	if (isspace((int) *s) || *s == '\\') {
+	    s++;
+	} else if (s[0] == '/' && s[1] == '*') {
+	    for (s += 2; s < end && !(s[0] == '*' && s[1] == '/'); s++)
+		;
+	    s += 2;
+	} else if (s[0] == '/' && s[1] == '/') {
+	    break;
+	} else {
+	    s = lex_token(s, &t);
+	    grow((void **) &m->body, m->nbody, &alloc, sizeof(token_t));
+	    m->body[m->nbody++] = t;
+	}
+    }
+}
+
+/* Record the macro defined at word, the text after #define */
+static void define(char *word, char *end) {
+    macro_t *m;
+    char *name;
+    int alloc = 0;
+
+    while (*word == ' ' || *word == '\t')
+	word++;
+    for (name = word; isalnum((int) *word) || *word == '_'; word++)
+	;
+    if (word == name)
+	return;
+    grow((void **) &macros, nmacros, &alloc_macros, sizeof(macro_t));
+    m = &macros[nmacros++];
+    memset(m, 0, sizeof(macro_t));
+    m->name = rules_strndup(name, word - name);
+    m->nparams = -1;
+    m->first = ntokens;
+    /* A parenthesis right after the name starts the parameters */
+    if (*word == '(') {
+	m->nparams = 0;
+	for (word++; word < end && *word != ')'; word++) {
+	    if (!isalpha((int) *word) && *word != '_')
+		continue;
+	    for (name = word; isalnum((int) *word) || *word == '_'; word++)
+		;
+	    grow((void **) &m->params, m->nparams, &alloc, sizeof(char *));
+	    m->params[m->nparams++] = rules_strndup(name, word - name);
+	    word--;
+	}
+	if (word < end)
+	    word++;
+    }
+    lex_body(m, word, end);
+}
+
+/* Handle preprocessor line at s.  #if 0 groups are skipped, and macros
+   are recorded.  Other conditionals are ignored, so that the code in
+   both branches is checked.  Return the end of the line */
+static char *directive(char *s, int *line) {
+    char *word = directive_word(s);
+
+    if (is_directive(word, "if")) {
+	word += 2;
+	while (*word == ' ' || *word == '\t')
+	    word++;
+	if (word[0] == '0' && !isalnum((int) word[1]))
+	    return skip_group(end_of_line(s, line), line);
+    }
+    if (is_directive(word, "define")) {
+	int end_line = *line;
+	define(word + 6, end_of_line(s, &end_line));
+    }
+    return end_of_line(s, line);
+}
+
+/* Scan the token that starts at s into t.  Return the end of it */
+static char *lex_token(char *s, token_t *t) {
+    char *start = s;
+    int i;
+
+    if (isalpha((int) *s) || *s == '_') {
+	while (isalnum((int) *s) || *s == '_')
+	    s++;
+	t->kind = T_IDENT;
+    } else if (isdigit((int) *s) || (s[0] == '.' && isdigit((int) s[1]))) {
+	/* Number, with any suffix.  It is floating point if it has
+	   a point or an exponent */
+	int hex = s[0] == '0' && (s[1] == 'x' || s[1] == 'X');
+	char *exp = hex ? "pP" : "eE";
+	t->kind = T_NUM;
+	for (;; s++) {
+	    if (*s == '.' || strchr(exp, *s))
+		t->kind = T_FLOAT;
+	    if ((*s == '+' || *s == '-') && strchr(exp, s[-1]))
+		continue;
+	    if (!isalnum((int) *s) && *s != '.')
+		break;
+	}
+    } else if (*s == '\'' || *s == '"') {
+	for (s++; *s && *s != *start && *s != '\n'; s++)
+	    if (*s == '\\' && s[1])
+		s++;
+	if (*s == *start)
+	    s++;
+	t->kind = T_QUOTE;
+    } else {
+	t->kind = T_OP;
+	for (i = 0; op_list[i]; i++)
+	    if (strncmp(s, op_list[i], strlen(op_list[i])) == 0)
+		break;
+	s += op_list[i] ? strlen(op_list[i]) : 1;
+    }
+    t->text = rules_strndup(start, s - start);
+    t->line = 0;
+    t->pos = 0;
+    return s;
+}
+
+static void free_macros() {
+    int i, k;
+
+    for (i = 0; i < nmacros; i++) {
+	for (k = 0; k < macros[i].nparams; k++)
+	    free(macros[i].params[k]);
+	for (k = 0; k < macros[i].nbody; k++)
+	    free(macros[i].body[k].text);
+	free(macros[i].name);
+	free(macros[i].params);
+	free(macros[i].body);
+    }
+    nmacros = 0;
+}
+
+/* Split text into tokens.  Return 0 if a comment isn't terminated,
+   setting *line to where it starts */
+static int lex(char *text, int *line) {
+    char *s = text;
+    int bol = 1;
+    token_t t;
+    int i;
+
+    for (i = 0; i < ntokens; i++)
+	free(tokens[i].text);
+    ntokens = 0;
+    free_macros();
+    *line = 1;
+    while (*s) {
+	if (*s == '\n') {
+	    (*line)++;
+	    bol = 1;
+	    s++;
+	    continue;
+	}
+	if (isspace((int) *s) || *s == '\\') {
+	    s++;
+	    continue;
+	}
+	if (*s == '#' && bol) {
+	    s = directive(s, line);
+	    continue;
+	}
+	if (s[0] == '/' && s[1] == '*') {
+	    int comment_line = *line;
+	    for (s += 2; *s && !(s[0] == '*' && s[1] == '/'); s++)
+		if (*s == '\n')
+		    (*line)++;
+	    if (!*s) {
+		*line = comment_line;
+		return 0;
+	    }
+	    s += 2;
+	    continue;
+	}
+	if (s[0] == '/' && s[1] == '/') {
+	    while (*s && *s != '\n')
+		s++;
+	    continue;
+	}
+	bol = 0;
+
+	i = s - text;
+	s = lex_token(s, &t);
+	t.line = *line;
+	t.pos = i;
+	grow((void **) &tokens, ntokens, &alloc_tokens, sizeof(token_t));
+	tokens[ntokens++] = t;
+    }
+    return 1;
+}
+
+/*
+ * Macro expansion.  Each use of a macro is replaced by its body, with
+ * the arguments of a function-like macro substituted for its
+ * parameters, and the result is expanded again.  The tokens of an
+ * expansion take the line and offset of the macro's name, so that
+ * problems are reported where the macro is used.  The # and ##
+ * operators aren't handled, since puzzle solutions have no use for
+ * them
+ */
+
+#define MAX_EXPANSION 16        /* Deepest nesting of expansions */
+#define MAX_ARGS 32
+
+static token_t *expanded = NULL;
+static int nexpanded = 0;
+static int alloc_expanded = 0;
+
+static int is_tok(token_t *t, char *op) {
+    return t->kind == T_OP && strcmp(t->text, op) == 0;
+}
+
+/* Index of macro named name defined before token index, or -1 */
+static int find_macro(char *name, int index) {
+    int m;
+    for (m = nmacros - 1; m >= 0; m--)
+	if (macros[m].first <= index && strcmp(macros[m].name, name) == 0)
+	    return m;
+    return -1;
+}
+
+static void emit(token_t *t, token_t *at) {
+    grow((void **) &expanded, nexpanded, &alloc_expanded, sizeof(token_t));
+    expanded[nexpanded] = *t;
+    expanded[nexpanded].text = rules_strndup(t->text, strlen(t->text));
+    if (at) {
+	expanded[nexpanded].line = at->line;
+	expanded[nexpanded].pos = at->pos;
+    }
+    nexpanded++;
+}
+
+/* Expand the n tokens at in, which are source tokens from index base
+   on, or part of an expansion standing for token at if base is -1 */
+static void expand(token_t *in, int n, int base, token_t *at, int depth) {
+    int start[MAX_ARGS + 1], end[MAX_ARGS + 1];
+    token_t *sub = NULL;
+    int alloc_sub = 0, nsub, nargs, level;
+    int i, j, k, m;
+
+    for (i = 0; i < n; i++) {
+	token_t *t = &in[i];
+	macro_t *mp;
+
+	m = t->kind == T_IDENT && depth < MAX_EXPANSION
+	    ? find_macro(t->text, base < 0 ? ntokens : base + i) : -1;
+	if (m >= 0 && macros[m].nparams >= 0
+	    && !(i + 1 < n && is_tok(&in[i+1], "(")))
+	    m = -1;
+	if (m < 0) {
+	    emit(t, at);
+	    continue;
+	}
+	mp = &macros[m];
+	if (mp->nparams < 0) {
+	    expand(mp->body, mp->nbody, -1, at ? at : t, depth + 1);
+	    continue;
+	}
+
+	/* Find the arguments, separated by commas outside parentheses */
+	nargs = 0;
+	level = 0;
+	start[0] = i + 2;
+	for (j = i + 2; j < n; j++) {
+	    if (is_tok(&in[j], "("))
+		level++;
+	    else if (is_tok(&in[j], ")") && level-- == 0)
+		break;
+	    else if (is_tok(&in[j], ",") && level == 0 && nargs < MAX_ARGS) {
+		end[nargs++] = j;
+		start[nargs] = j + 1;
+	    }
+	}
+	if (j == n) {
+	    emit(t, at);
+	    continue;
+	}
+	end[nargs++] = j;
+
+	nsub = 0;
+	for (k = 0; k < mp->nbody; k++) {
+	    token_t *b = &mp->body[k];
+	    int p, a;
+	    for (p = 0; p < mp->nparams && p < nargs; p++)
+		if (b->kind == T_IDENT && strcmp(b->text, mp->params[p]) == 0)
+		    break;
+	    if (p < mp->nparams && p < nargs) {
+		for (a = start[p]; a < end[p]; a++) {
+		    grow((void **) &sub, nsub, &alloc_sub, sizeof(token_t));
+		    sub[nsub++] = in[a];
+		}
+	    } else {
+		grow((void **) &sub, nsub, &alloc_sub, sizeof(token_t));
+		sub[nsub++] = *b;
+	    }
+	}
+	expand(sub, nsub, -1, at ? at : t, depth + 1);
+	i = j;
+    }
+    free(sub);
+}
+
+/* Replace the tokens with their expansion */
+static void expand_macros() {
+    token_t *t;
+    int i, n;
+
+    nexpanded = 0;
+    expand(tokens, ntokens, 0, NULL, 0);
+    for (i = 0; i < ntokens; i++)
+	free(tokens[i].text);
+    t = tokens;
+    n = alloc_tokens;
+    tokens = expanded;
+    ntokens = nexpanded;
+    alloc_tokens = alloc_expanded;
+    expanded = t;
+    alloc_expanded = n;
+}
+
+static int is_op(int i, char *op) {
+    return i >= 0 && i < ntokens && tokens[i].kind == T_OP && strcmp(tokens[i].text, op) == 0;
+}
+
+static int in_list(char *word, char *list[]) {
+    int i;
+    for (i = 0; list[i]; i++)
+	if (strcmp(word, list[i]) == 0)
+	    return 1;
+    return 0;
+}
+
+/* Words that make up types */
+static char *type_words[] = {
+    "int", "unsigned", "signed", "char", "short", "long", "float",
+    "double", "void", "_Bool", "struct", "union", "enum", NULL
+};
+
+/* Words that can go with types, and are ignored */
+static char *qualifier_words[] = {
+    "const", "volatile", "register", "static", "auto", "extern",
+    "inline", "typedef", NULL
+};
+
+/* Statements that are illegal in integer puzzles */
+static char *control_words[] = {
+    "if", "while", "do", "for", "switch", "goto", NULL
+};
+
+/* Other keywords */
+static char *other_words[] = {
+    "else", "break", "continue", "case", "default", "return", NULL
+};
+
+static int is_type_word(int i) {
+    return tokens[i].kind == T_IDENT
+	&& (in_list(tokens[i].text, type_words)
+	    || in_list(tokens[i].text, qualifier_words));
+}
+
+/***************************
+ * Checking the functions
+ ***************************/
+
+static char *src_name;          /* File name for messages */
+static FILE *msg_out;
+static rule_t *cur_rule;        /* Rules for the current function */
+static int float_rules;         /* Does it follow the floating point rules? */
+static rule_result_t *cur;
+static int late_decl_line;      /* Line of a declaration that follows a
+				   statement, or 0 if none */
+
+/* Variables of the current function */
+static char **locals = NULL;
+static int nlocals = 0;
+static int alloc_locals = 0;
+
+/* Report problem with current function */
+static void report(int line, char *fmt, ...) {
+    va_list ap;
+
+    if (!msg_out)
+	return;
+    fprintf(msg_out, "dlcheck:%s:%d:%s: ", src_name, line, cur->name);
+    va_start(ap, fmt);
+    vfprintf(msg_out, fmt, ap);
+    va_end(ap);
+    fprintf(msg_out, "\n");
+}
+
+#define violation(...) (cur->errors++, report(__VA_ARGS__))
+
+static int is_named(char **names, int n, char *name) {
+    int i;
+    for (i = 0; i < n; i++)
+	if (strcmp(names[i], name) == 0)
+	    return 1;
+    return 0;
+}
+
+static void add_local(char *name) {
+    grow((void **) &locals, nlocals, &alloc_locals, sizeof(char *));
+    locals[nlocals++] = name;
+}
+
+/* Check the run of type words starting at token i.  Return the index
+   after it */
+static int check_type(int i) {
+    for (; i < ntokens && is_type_word(i); i++) {
+	char *word = tokens[i].text;
+	/* As with dlc, long and signed are taken as forms of int */
+	if (in_list(word, qualifier_words) || strcmp(word, "int") == 0
+	    || strcmp(word, "long") == 0 || strcmp(word, "signed") == 0
+	    || (float_rules && strcmp(word, "unsigned") == 0))
+	    continue;
+	violation(tokens[i].line, "Illegal data type: %s", word);
+	/* Skip the tag */
+	if ((strcmp(word, "struct") == 0 || strcmp(word, "union") == 0
+	     || strcmp(word, "enum") == 0)
+	    && i + 1 < ntokens && tokens[i+1].kind == T_IDENT)
+	    i++;
+    }
+    return i;
+}
+
+static int op_allowed(char *op) {
+    char *s = cur_rule->ops;
+    int len = strlen(op);
+
+    if (float_rules)
+	return 1;
+    while (*s) {
+	while (*s == ' ')
+	    s++;
+	if (strncmp(s, op, len) == 0 && (s[len] == ' ' || s[len] == '\0'))
+	    return 1;
+	while (*s && *s != ' ')
+	    s++;
+    }
+    return 0;
+}
+
+/* Count operator op at line */
+static void count_op(int line, char *op) {
+    cur->ops++;
+    if (!op_allowed(op))
+	violation(line, "Illegal operator (%s)", op);
+}
+
+static void check_const(token_t *t) {
+    unsigned long long val;
+
+    if (t->kind == T_FLOAT || (t->kind == T_QUOTE && t->text[0] == '"')
+	|| (t->kind == T_QUOTE && !float_rules)) {
+	violation(t->line, "Illegal constant type (%s)", t->text);
+	return;
+    }
+    val = strtoull(t->text, NULL, 0);
+    if (t->kind == T_NUM && !float_rules && val > 0xff)
+	violation(t->line, "Illegal constant (%s) (only 0x0 - 0xff allowed)",
+		  t->text);
+}
+
+/*
+ * check_body - Check the statements between the braces at tokens b
+ * and e.  Operators are told apart from their unary forms by whether
+ * the token before them ends an operand.  As with dlc, ?: and the
+ * comma operator aren't counted, and conditions cost nothing in the
+ * floating point puzzles, where control flow is allowed.  As in C89,
+ * which dlc compiles, declarations must come before the statements of
+ * their block
+ */
+static void check_body(int b, int e) {
+    int operand = 0;            /* Does the last token end an operand? */
+    int depth = 0;              /* Parentheses */
+    int decl = -1;              /* Depth of declaration, or -1 if none */
+    int declarator = 0;         /* Is a variable name expected? */
+    int leading = 1;            /* In the declarations at the start? */
+    int stmts[64];              /* Has each open block had a statement? */
+    int block = 0;
+    int i, j;
+
+    stmts[0] = 0;
+    for (i = b + 1; i < e; i++) {
+	token_t *t = &tokens[i];
+	char *op = t->text;
+
+	if (depth == 0 && !is_op(i, "}")
+	    && (i == b + 1 || is_op(i - 1, ";") || is_op(i - 1, "{")
+		|| is_op(i - 1, "}"))) {
+	    if (!is_type_word(i))
+		stmts[block] = 1;
+	    else if (stmts[block] && !late_decl_line)
+		late_decl_line = t->line;
+	}
+	if (is_type_word(i) && is_op(i - 1, "(") && i >= 2
+	    && strcmp(tokens[i-2].text, "for") == 0 && !late_decl_line)
+	    late_decl_line = t->line;
+	if (is_op(i, "{") && block < 63)
+	    stmts[++block] = 0;
+	else if (is_op(i, "}") && block > 0)
+	    block--;
+
+	if (leading && depth == 0 && (i == b + 1 || is_op(i - 1, ";"))
+	    && !is_type_word(i)) {
+	    leading = 0;
+	    cur->zap_ops = cur->ops;
+	}
+	if (leading && depth == 0 && is_op(i, ";"))
+	    cur->zap_start = t->pos + 1;
+
+	if (t->kind == T_IDENT) {
+	    if (is_type_word(i)) {
+		j = check_type(i);
+		while (is_op(j, "*"))
+		    j++;
+		if (is_op(i - 1, "(") && is_op(j, ")")) {
+		    violation(t->line, "Illegal cast");
+		    i = j;
+		} else {
+		    decl = depth;
+		    declarator = 1;
+		    i = j - 1;
+		}
+		operand = 0;
+	    } else if (declarator) {
+		add_local(op);
+		declarator = 0;
+		operand = 1;
+	    } else if (in_list(op, control_words)) {
+		if (!float_rules)
+		    violation(t->line, "Illegal %s", op);
+		operand = 0;
+	    } else if (in_list(op, other_words)) {
+		operand = 0;
+	    } else if (strcmp(op, "sizeof") == 0) {
+		violation(t->line, "Illegal operator (sizeof)");
+		operand = 0;
+	    } else {
+		if (is_named(locals, nlocals, op))
+		    ;
+		else if (is_op(i + 1, "("))
+		    violation(t->line, "Illegal function invocation (%s)", op);
+		else if (find_macro(op, ntokens) >= 0)
+		    violation(t->line, "Illegal macro (%s)", op);
+		else
+		    violation(t->line, "Illegal global variable (%s)", op);
+		operand = 1;
+	    }
+	    continue;
+	}
+	if (t->kind != T_OP) {
+	    check_const(t);
+	    operand = 1;
+	    continue;
+	}
+
+	if (strcmp(op, "(") == 0)
+	    depth++;
+	else if (strcmp(op, ")") == 0) {
+	    if (--depth < decl)
+		decl = -1;
+	} else if (strcmp(op, ";") == 0 || strcmp(op, "{") == 0
+		   || strcmp(op, "}") == 0) {
+	    if (decl >= depth || strcmp(op, ";") != 0)
+		decl = -1;
+	    declarator = 0;
+	} else if (strcmp(op, ",") == 0)
+	    declarator = decl == depth;
+	else if (strcmp(op, "[") == 0)
+	    violation(t->line, "Illegal array operator '[]'.");
+	else if (strcmp(op, "?") == 0) {
+	    if (!float_rules)
+		violation(t->line, "Illegal ternary if");
+	} else if (strcmp(op, ".") == 0 || strcmp(op, "->") == 0)
+	    violation(t->line, "Illegal operator (%s)", op);
+	else if (strcmp(op, "++") == 0 || strcmp(op, "--") == 0) {
+	    count_op(t->line, op);
+	    continue;
+	} else if (strcmp(op, "*") == 0 && declarator)
+	    continue;
+	else if (!operand && (strcmp(op, "&") == 0 || strcmp(op, "*") == 0)) {
+	    /* Address and indirection */
+	    cur->ops++;
+	    violation(t->line, "Illegal operator (%s)", op);
+	} else if (strlen(op) > 1 && op[strlen(op) - 1] == '='
+		   && strcmp(op, "==") != 0 && strcmp(op, "!=") != 0
+		   && strcmp(op, "<=") != 0 && strcmp(op, ">=") != 0) {
+	    /* Assignment operator, such as += */
+	    char name[4];
+	    strncpy(name, op, sizeof(name));
+	    name[strlen(op) - 1] = '\0';
+	    count_op(t->line, name);
+	} else if (strcmp(op, "=") != 0 && strcmp(op, ":") != 0
+		   && strcmp(op, "]") != 0)
+	    count_op(t->line, op);
+	operand = strcmp(op, ")") == 0 || strcmp(op, "]") == 0;
+    }
+}
+
+/*
+ * check_function - Check the function whose name is token n, with its
+ * parameter list from token p to its closing parenthesis, and its
+ * body from token b to token e
+ */
+static void check_function(int n, int p, int b, int e, rule_t rules[],
+			   int flags) {
+    int i;
+
+    cur->name = rules_strndup(tokens[n].text, strlen(tokens[n].text));
+    cur->line = tokens[e].line;
+    cur->body_start = tokens[b].pos;
+    cur->body_end = tokens[e].pos;
+    cur->zap_start = cur->body_start + 1;
+    nlocals = 0;
+
+    for (cur_rule = rules; cur_rule->name; cur_rule++)
+	if (strcmp(cur_rule->name, cur->name) == 0)
+	    break;
+    if (!cur_rule->name) {
+	violation(cur->line, "Illegal function definition");
+	return;
+    }
+    float_rules = strcmp(cur_rule->ops, "$") == 0;
+    cur->max_ops = cur_rule->max_ops;
+
+    /* Return type and parameters */
+    for (i = n - 1; i >= 0 && is_type_word(i); i--)
+	;
+    check_type(i + 1);
+    if (!(is_op(p + 2, ")") && strcmp(tokens[p+1].text, "void") == 0))
+	for (i = p + 1; i < b - 1; i++) {
+	    if (is_type_word(i))
+		i = check_type(i) - 1;
+	    else if (tokens[i].kind == T_IDENT)
+		add_local(tokens[i].text);
+	    else if (is_op(i, "["))
+		violation(tokens[i].line, "Illegal array operator '[]'.");
+	}
+    check_body(b, e);
+
+    if (cur->ops > cur->max_ops)
+	report(cur->line, "Warning: %d operators exceeds max of %d",
+	       cur->ops, cur->max_ops);
+    else if (flags & RULES_COUNT)
+	report(cur->line, "%d operators", cur->ops);
+}
+
+int rules_check(char *text, char *fname, rule_t rules[], int flags,
+		FILE *out, rule_result_t **results) {
+    rule_result_t *r = NULL;
+    int alloc_r = 0, nr = 0;
+    int depth = 0, start = 0;
+    int line, i, j, k;
+
+    src_name = fname;
+    msg_out = out;
+    late_decl_line = 0;
+    if (!lex(text, &line)) {
+	if (out)
+	    fprintf(out, "%s:%d: unterminated comment\n", fname, line);
+	return -1;
+    }
+    expand_macros();
+
+    for (i = 0; i < ntokens; i++) {
+	if (is_op(i, "(") || is_op(i, "[") || (is_op(i, "{") && depth > 0))
+	    depth++;
+	else if (is_op(i, ")") || is_op(i, "]") || is_op(i, "}"))
+	    depth--;
+	else if (is_op(i, ";") && depth == 0)
+	    start = i + 1;
+	else if (is_op(i, "{") && is_op(i - 1, ")")) {
+	    /* Function definition.  Find its name and its end */
+	    for (j = i - 1, k = 0; j >= start; j--) {
+		k += is_op(j, ")") - is_op(j, "(");
+		if (k == 0)
+		    break;
+	    }
+	    for (k = i, depth = 0; k < ntokens; k++) {
+		depth += is_op(k, "{") - is_op(k, "}");
+		if (depth == 0)
+		    break;
+	    }
+	    if (j < start || j == 0 || tokens[j-1].kind != T_IDENT
+		|| k == ntokens)
+		break;
+	    grow((void **) &r, nr, &alloc_r, sizeof(rule_result_t));
+	    cur = &r[nr++];
+	    memset(cur, 0, sizeof(rule_result_t));
+	    check_function(j - 1, j, i, k, rules, flags);
+	    if (rules_zapped(cur, flags))
+		report(cur->line, "Zapping function body!");
+	    i = k;
+	    start = k + 1;
+	} else if (is_op(i, "{"))
+	    depth++;
+	if (depth < 0)
+	    break;
+    }
+    if (i < ntokens || depth != 0) {
+	if (out)
+	    fprintf(out, "%s:%d: syntax error\n", fname,
+		    i < ntokens ? tokens[i].line : line);
+	free(r);
+	return -1;
+    }
+    if (late_decl_line) {
+	if (out)
+	    fprintf(out, "%s:%d: syntax error: declaration after a statement\n",
+		    fname, late_decl_line);
+	free(r);
+	return -1;
+    }
+    *results = r;
+    return nr;
+}
+
+int rules_zapped(rule_result_t *r, int flags) {
+    if (r->errors > 0)
+	return (flags & (RULES_ZAP | RULES_ZAP_OPS)) != 0;
+    return (flags & RULES_ZAP_OPS) && r->max_ops > 0 && r->ops > r->max_ops;
+}
+
+char *rules_read_file(char *fname) {
+    FILE *fp = fopen(fname, "r");
+    char *text = NULL;
+    int alloc = 0, len = 0, n;
+
+    if (!fp)
+	return NULL;
+    do {
+	grow((void **) &text, len + 4096, &alloc, 1);
+	n = fread(text + len, 1, alloc - len - 1, fp);
+	len += n;
+    } while (n > 0);
+    fclose(fp);
+    text[len] = '\0';
+    return text;
+}
+
+/* Copy of string constant at token i, without its quotes */
+static char *unquote(int i) {
+    char *s = tokens[i].text;
+    return rules_strndup(s + 1, strlen(s) - 2);
+}
+
+/*
+ * Each entry of the table has the form
+ *   {"name", (funct_t) name, (funct_t) test_name, args, "ops", limit, ...
+ */
+rule_t *rules_read_decl(char *fname) {
+    char *text = rules_read_file(fname);
+    rule_t *rules = NULL;
+    int alloc = 0, n = 0;
+    int line, i, k;
+    static char *pattern[] = {
+	"{", "\"", ",", "(", "a", ")", "a", ",", "(", "a", ")", "a", ",",
+	"0", ",", "\"", ",", "0", NULL
+    };
+
+    if (!text || !lex(text, &line))
+	return NULL;
+    for (i = 0; i < ntokens; i++) {
+	for (k = 0; pattern[k] && i + k < ntokens; k++) {
+	    token_t *t = &tokens[i+k];
+	    if (pattern[k][0] == '"' ? t->kind != T_QUOTE || t->text[0] != '"'
+		: pattern[k][0] == 'a' ? t->kind != T_IDENT
+		: pattern[k][0] == '0' ? t->kind != T_NUM
+		: !is_op(i + k, pattern[k]))
+		break;
+	}
+	if (pattern[k] || strlen(tokens[i+1].text) <= 2)
+	    continue;
+	grow((void **) &rules, n + 1, &alloc, sizeof(rule_t));
+	rules[n].name = unquote(i + 1);
+	rules[n].ops = unquote(i + 15);
+	rules[n].max_ops = strtol(tokens[i+17].text, NULL, 0);
+	n++;
+    }
+    free(text);
+    if (n == 0) {
+	free(rules);
+	return NULL;
+    }
+    rules[n].name = NULL;
+    return rules;
+}
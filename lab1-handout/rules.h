@@ -0,0 +1,59 @@
+/*
+ * CS 208 Lab 1: Data Lab
+ *
+ * rules.h - Check puzzle solutions against the coding rules, and count
+ * their operators, as dlc does
+ *
+ * The checker works on the tokens of the source rather than on a full
+ * parse, so it runs in a few milliseconds, and can be run by btest
+ * itself.  It doesn't look for syntax errors, which the C compiler
+ * reports anyway.
+ */
+
+/* Coding rules for a puzzle, from its entry in decl.c */
+typedef struct {
+    char *name;
+    char *ops;          /* Operators allowed, or "$" for the floating
+			   point rules */
+    int max_ops;
+} rule_t;
+
+/* Result of checking a function */
+typedef struct {
+    char *name;
+    int line;           /* Line of the closing brace */
+    int body_start;     /* Offsets of the braces around the body */
+    int body_end;
+    int zap_start;      /* Where a zapped body starts: dlc keeps the
+			   declarations at the start of the body */
+    int ops;            /* Operators used */
+    int zap_ops;        /* Operators left in the kept declarations */
+    int max_ops;        /* Most allowed, or 0 if not a puzzle */
+    int errors;         /* Coding rule violations */
+} rule_result_t;
+
+/* Flags for rules_check */
+#define RULES_COUNT   1 /* Report the operator count of each function */
+#define RULES_ZAP     2 /* Report functions that break the rules as zapped */
+#define RULES_ZAP_OPS 4 /* Also those with too many operators */
+
+/*
+ * Check the functions defined in text against rules, which end with
+ * an entry whose name is NULL.  Problems are reported to out, unless
+ * it is NULL, as coming from file fname.  Store the results in
+ * *results, and return how many there are, or -1 if the text has
+ * unbalanced braces, an unterminated comment, or a declaration after
+ * a statement in its block, which C89 and dlc don't allow.
+ */
+int rules_check(char *text, char *fname, rule_t rules[], int flags,
+		FILE *out, rule_result_t **results);
+
+/* Is the function zapped under flags? */
+int rules_zapped(rule_result_t *r, int flags);
+
+/* Read file into a string.  Return NULL if it can't be read */
+char *rules_read_file(char *fname);
+
+/* Read the rules from the test_set table in decl.c.  Return NULL if
+   the file can't be read or has no puzzles */
+rule_t *rules_read_decl(char *fname);
@@ -0,0 +1,12 @@
+/* block-decl.c: Declarations at the start of a nested block, accepted */
+unsigned floatNegate(unsigned uf) {
+  unsigned r = uf;
+  if ((uf & 0x7fffffff) > 0x7f800000) {
+    r = uf;
+    {
+      unsigned s = 1;
+      r = r + s - s;
+    }
+  }
+  return r ^ 0x80000000;
+}
@@ -0,0 +1,6 @@
+/* decl-list.c: Several variables in one declaration, accepted */
+int bitAnd(int x, int y) {
+  int a = ~x, b;
+  b = ~y;
+  return ~(a | b);
+}
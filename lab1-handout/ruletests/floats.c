@@ -0,0 +1,63 @@
+/* floats.c: solutions to the floating point puzzles, which use if,
+   while, and unsigned as the float rules allow */
+unsigned floatNegate(unsigned uf) {
+  unsigned exp = (uf >> 23) & 0xff;
+  unsigned frac = uf & 0x7fffff;
+  if (exp == 0xff && frac)
+    return uf;
+  return uf ^ 0x80000000;
+}
+unsigned floatScale2(unsigned uf) {
+  unsigned sign = uf & 0x80000000;
+  unsigned exp = (uf >> 23) & 0xff;
+  if (exp == 0xff)
+    return uf;
+  if (exp == 0)
+    return sign | (uf << 1);
+  exp = exp + 1;
+  if (exp == 0xff)
+    return sign | 0x7f800000;
+  return sign | (exp << 23) | (uf & 0x7fffff);
+}
+unsigned floatInt2Float(int x) {
+  unsigned sign = 0;
+  unsigned abs = x;
+  unsigned exp = 158;
+  unsigned frac, rest;
+  if (!x)
+    return 0;
+  if (x < 0) {
+    sign = 0x80000000;
+    abs = -abs;
+  }
+  while (!(abs & 0x80000000)) {
+    abs = abs << 1;
+    exp = exp - 1;
+  }
+  frac = (abs >> 8) & 0x7fffff;
+  rest = abs & 0xff;
+  if (rest > 0x80 || (rest == 0x80 && (frac & 1))) {
+    frac = frac + 1;
+    if (frac >> 23) {
+      frac = 0;
+      exp = exp + 1;
+    }
+  }
+  return sign | (exp << 23) | frac;
+}
+int floatFloat2Int(unsigned uf) {
+  int exp = ((uf >> 23) & 0xff) - 127;
+  unsigned frac = (uf & 0x7fffff) | 0x800000;
+  int result;
+  if (exp < 0)
+    return 0;
+  if (exp > 30)
+    return 0x80000000u;
+  if (exp > 23)
+    result = frac << (exp - 23);
+  else
+    result = frac >> (23 - exp);
+  if (uf >> 31)
+    result = -result;
+  return result;
+}
@@ -0,0 +1,10 @@
+/* late-decl-block.c: The same in a nested block, rejected */
+unsigned floatNegate(unsigned uf) {
+  unsigned r = uf;
+  if ((uf & 0x7fffffff) > 0x7f800000) {
+    r = uf;
+    unsigned s = 1;
+    return r + s - s;
+  }
+  return r ^ 0x80000000;
+}
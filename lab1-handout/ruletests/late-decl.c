@@ -0,0 +1,7 @@
+/* late-decl.c: A declaration after a statement, rejected */
+int bitAnd(int x, int y) {
+  int a = ~x;
+  a = a | ~y;
+  int b = ~a;
+  return b;
+}
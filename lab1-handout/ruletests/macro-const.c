@@ -0,0 +1,13 @@
+/* macro-const.c: Constants named by macros, expanded as dlc does */
+#define MASK 0xff
+#define SHIFT 24
+#define BIG 0x1ff
+int getByte(int x, int n) {
+  return (x >> (n << 3)) & MASK;
+}
+int logicalNeg(int x) {
+  return ((x | (~x + 1)) >> SHIFT >> 7) + 1;
+}
+int bitXor(int x, int y) {
+  return BIG;
+}
@@ -0,0 +1,13 @@
+/* macro-func.c: Function-like macros, and macros that use others */
+#define NEG(x) (~(x) + 1)
+#define OR(a, b) ((a) | (b))
+#define NOT_AND(x, y) OR(~x, ~y)
+int absVal(int x) {
+  return NEG(x);
+}
+int bitAnd(int x, int y) {
+  return ~NOT_AND(x, y);
+}
+int bitXor(int x, int y) {
+  return NEG(x) - y;
+}
@@ -0,0 +1,21 @@
+/* types.c: long and signed are accepted, as forms of int, and other
+   types are not */
+int sign(int x) {
+  signed a = x;
+  long b = a;
+  long long c = b;
+  return c;
+}
+int bitAnd(int x, int y) {
+  short a = x;
+  return a;
+}
+int getByte(int x, int n) {
+  unsigned a = x;
+  return a;
+}
+unsigned floatNegate(unsigned uf) {
+  long a = uf;
+  unsigned long b = a;
+  return b;
+}
@@ -0,0 +1,694 @@
+/*
+ * CS 208 Lab 1: Data Lab
+ *
+ * sat.c - Boolean satisfiability solver, with a circuit builder
+ *
+ * The solver is a conflict-driven clause learning (CDCL) solver in
+ * the style of MiniSat: two watched literals per clause for unit
+ * propagation, first-UIP learning, VSIDS variable activities kept in
+ * a heap, saved phases, and restarts following the Luby sequence.
+ * At restarts, the learned clauses with the most distinct decision
+ * levels (LBD) are discarded when there are too many of them.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sat.h"
+
+#define VAR(lit) ((lit) >> 1)
+#define NEG(lit) ((lit) & 1)
+
+/* Values of variables */
+#define V_FALSE 0
+#define V_TRUE  1
+#define V_UNDEF 2
+
+/* Conflicts between restarts are this times the Luby sequence */
+#define RESTART_BASE 100
+
+/* Learned clauses kept before the first reduction */
+#define INITIAL_LEARNTS 10000
+
+/* Learned clauses with LBD at most this are never discarded */
+#define GLUE_LBD 2
+
+#define ACTIVITY_DECAY 0.95
+
+/* Clauses are stored in an arena of integers: size, LBD (0 for
+   original clauses), then the literals.  The first two literals are
+   the watched ones */
+#define C_SIZE(c) arena[c]
+#define C_LBD(c)  arena[(c)+1]
+#define C_LITS(c) (&arena[(c)+2])
+
+static int *arena = NULL;
+static int arena_n = 0, arena_cap = 0;
+
+/* Clauses watching each literal */
+typedef struct {
+    int *list;
+    int n, cap;
+} watch_t;
+
+static int nvars = 0, alloc_vars = 0;
+static watch_t *watches = NULL;         /* Indexed by literal */
+static char *values = NULL;             /* V_FALSE, V_TRUE, or V_UNDEF */
+static char *phases = NULL;             /* Last value of each variable */
+static char *seen = NULL;
+static int *levels = NULL;
+static int *reasons = NULL;             /* Clause that implied value, or -1 */
+static double *activity = NULL;
+static double var_inc = 1.0;
+
+/* Assigned literals, in order */
+static int *trail = NULL;
+static int trail_n = 0, qhead = 0;
+static int *trail_lim = NULL;           /* Start of each decision level */
+static int nlevels = 0;
+
+/* Heap of unassigned variables, by activity */
+static int *heap = NULL;
+static int heap_n = 0;
+static int *heap_pos = NULL;            /* Position in heap, or -1 */
+
+static int nclauses = 0, nlearnts = 0, max_learnts = INITIAL_LEARNTS;
+static int unsat = 0;                   /* Found conflict at level 0 */
+
+/* Scratch space for building clauses */
+static int *tmp = NULL;
+static int tmp_cap = 0;
+
+/* Table of gates for sharing, with open addressing */
+typedef struct {
+    int op, a, b, c;
+    int result;
+} gate_t;
+
+static gate_t *gates = NULL;
+static int gate_size = 0, ngates = 0;
+
+static void *sat_alloc(void *p, size_t size) {
+    p = realloc(p, size);
+    if (!p) {
+	printf("Couldn't allocate space for SAT solver\n");
+	exit(1);
+    }
+    return p;
+}
+
+/* Make room for n more elements in array *p of *cap elements */
+static void *reserve(void *p, int *cap, int used, int n, size_t elt) {
+    if (used + n > *cap) {
+	while (used + n > *cap)
+	    *cap = *cap ? 2 * *cap : 16;
+	p = sat_alloc(p, *cap * elt);
+    }
+    return p;
+}
+
+static int lit_value(int lit) {
+    int v = values[VAR(lit)];
+    return v == V_UNDEF ? V_UNDEF : v ^ NEG(lit);
+}
+
+/**************************
+ * Heap of variables
+ **************************/
+
+static void heap_swap(int i, int j) {
+    int t = heap[i];
+    heap[i] = heap[j];
+    heap[j] = t;
+    heap_pos[heap[i]] = i;
+    heap_pos[heap[j]] = j;
+}
+
+static void heap_up(int i) {
+    while (i > 0 && activity[heap[(i-1)/2]] < activity[heap[i]]) {
+	heap_swap(i, (i-1)/2);
+	i = (i-1)/2;
+    }
+}
+
+static void heap_down(int i) {
+    for (;;) {
+	int l = 2*i + 1, r = l + 1, m = i;
+	if (l < heap_n && activity[heap[l]] > activity[heap[m]])
+	    m = l;
+	if (r < heap_n && activity[heap[r]] > activity[heap[m]])
+	    m = r;
+	if (m == i)
+	    return;
+	heap_swap(i, m);
+	i = m;
+    }
+}
+
+static void heap_insert(int v) {
+    if (heap_pos[v] >= 0)
+	return;
+    heap[heap_n] = v;
+    heap_pos[v] = heap_n++;
+    heap_up(heap_n - 1);
+}
+
+static int heap_pop() {
+    int v = heap[0];
+    heap_swap(0, --heap_n);
+    heap_pos[v] = -1;
+    heap_down(0);
+    return v;
+}
+
+static void bump(int v) {
+    int i;
+    if ((activity[v] += var_inc) > 1e100) {
+	/* Rescale all activities */
+	for (i = 0; i < nvars; i++)
+	    activity[i] *= 1e-100;
+	var_inc *= 1e-100;
+    }
+    if (heap_pos[v] >= 0)
+	heap_up(heap_pos[v]);
+}
+
+/**************************
+ * Variables and clauses
+ **************************/
+
+static void watch(int lit, int c) {
+    watch_t *w = &watches[lit];
+    w->list = reserve(w->list, &w->cap, w->n, 1, sizeof(int));
+    w->list[w->n++] = c;
+}
+
+static void enqueue(int lit, int reason) {
+    int v = VAR(lit);
+    values[v] = !NEG(lit);
+    levels[v] = nlevels;
+    reasons[v] = reason;
+    trail[trail_n++] = lit;
+}
+
+int sat_new_var() {
+    int v = nvars;
+    if (nvars == alloc_vars) {
+	alloc_vars = alloc_vars ? 2 * alloc_vars : 1024;
+	watches = sat_alloc(watches, 2 * alloc_vars * sizeof(watch_t));
+	memset(watches + 2 * nvars, 0, 2 * (alloc_vars - nvars) * sizeof(watch_t));
+	values = sat_alloc(values, alloc_vars);
+	phases = sat_alloc(phases, alloc_vars);
+	seen = sat_alloc(seen, alloc_vars);
+	levels = sat_alloc(levels, alloc_vars * sizeof(int));
+	reasons = sat_alloc(reasons, alloc_vars * sizeof(int));
+	activity = sat_alloc(activity, alloc_vars * sizeof(double));
+	trail = sat_alloc(trail, alloc_vars * sizeof(int));
+	trail_lim = sat_alloc(trail_lim, alloc_vars * sizeof(int));
+	heap = sat_alloc(heap, alloc_vars * sizeof(int));
+	heap_pos = sat_alloc(heap_pos, alloc_vars * sizeof(int));
+    }
+    nvars++;
+    values[v] = V_UNDEF;
+    phases[v] = V_FALSE;
+    seen[v] = 0;
+    levels[v] = 0;
+    reasons[v] = -1;
+    activity[v] = 0.0;
+    heap_pos[v] = -1;
+    heap_insert(v);
+    return 2 * v;
+}
+
+/* Add clause of n literals, which must be at decision level 0 */
+static void add_clause(int lits[], int n, int lbd) {
+    int c, i, j;
+
+    /* Drop false literals, and clauses that are already satisfied */
+    for (i = j = 0; i < n; i++) {
+	int val = lit_value(lits[i]);
+	if (val == V_TRUE)
+	    return;
+	if (val == V_UNDEF)
+	    lits[j++] = lits[i];
+    }
+    n = j;
+    if (n == 0) {
+	unsat = 1;
+	return;
+    }
+    if (n == 1) {
+	enqueue(lits[0], -1);
+	return;
+    }
+    arena = reserve(arena, &arena_cap, arena_n, n + 2, sizeof(int));
+    c = arena_n;
+    arena_n += n + 2;
+    C_SIZE(c) = n;
+    C_LBD(c) = lbd;
+    memcpy(C_LITS(c), lits, n * sizeof(int));
+    watch(lits[0], c);
+    watch(lits[1], c);
+    if (lbd)
+	nlearnts++;
+    else
+	nclauses++;
+}
+
+/* Add original clause of n literals, from a, b, and c */
+static void clause(int n, int a, int b, int c) {
+    int lits[3];
+    lits[0] = a;
+    lits[1] = b;
+    lits[2] = c;
+    add_clause(lits, n, 0);
+}
+
+void sat_assert(int a) {
+    clause(1, a, 0, 0);
+}
+
+void sat_reset() {
+    int i;
+    for (i = 0; i < 2 * nvars; i++)
+	watches[i].n = 0;
+    nvars = 0;
+    arena_n = 0;
+    trail_n = qhead = 0;
+    nlevels = 0;
+    heap_n = 0;
+    var_inc = 1.0;
+    nclauses = nlearnts = 0;
+    max_learnts = INITIAL_LEARNTS;
+    unsat = 0;
+    ngates = 0;
+    for (i = 0; i < gate_size; i++)
+	gates[i].op = 0;
+
+    /* Variable 0 is the constant true */
+    sat_new_var();
+    heap_n = 0;
+    heap_pos[0] = -1;
+    enqueue(SAT_TRUE, -1);
+}
+
+int sat_var_count() {
+    return nvars;
+}
+
+int sat_clause_count() {
+    return nclauses;
+}
+
+int sat_value(int a) {
+    return lit_value(a) == V_TRUE;
+}
+
+/**************************
+ * Search
+ **************************/
+
+/* Propagate assignments on trail.  Return conflicting clause, or -1 */
+static int propagate() {
+    while (qhead < trail_n) {
+	int false_lit = trail[qhead++] ^ 1;
+	watch_t *w = &watches[false_lit];
+	int i, j, k;
+
+	for (i = j = 0; i < w->n; i++) {
+	    int c = w->list[i];
+	    int *lits = C_LITS(c);
+	    int n = C_SIZE(c);
+
+	    if (lits[0] == false_lit) {
+		lits[0] = lits[1];
+		lits[1] = false_lit;
+	    }
+	    if (lit_value(lits[0]) == V_TRUE) {
+		w->list[j++] = c;
+		continue;
+	    }
+	    /* Look for another literal to watch */
+	    for (k = 2; k < n; k++)
+		if (lit_value(lits[k]) != V_FALSE)
+		    break;
+	    if (k < n) {
+		lits[1] = lits[k];
+		lits[k] = false_lit;
+		watch(lits[1], c);
+		continue;
+	    }
+	    /* Clause is unit or conflicting */
+	    w->list[j++] = c;
+	    if (lit_value(lits[0]) == V_FALSE) {
+		while (++i < w->n)
+		    w->list[j++] = w->list[i];
+		w->n = j;
+		qhead = trail_n;
+		return c;
+	    }
+	    enqueue(lits[0], c);
+	}
+	w->n = j;
+    }
+    return -1;
+}
+
+static void backtrack(int level) {
+    if (nlevels <= level)
+	return;
+    while (trail_n > trail_lim[level]) {
+	int v = VAR(trail[--trail_n]);
+	phases[v] = values[v];
+	values[v] = V_UNDEF;
+	heap_insert(v);
+    }
+    qhead = trail_n;
+    nlevels = level;
+}
+
+/*
+ * Derive first-UIP clause from conflict, storing it in tmp with the
+ * asserting literal first and a literal of the highest remaining
+ * level second.  Return its length
+ */
+static int analyze(int confl, int *bt_level) {
+    int n = 1, pending = 0, p = -1, idx = trail_n - 1;
+    int i, max_i;
+
+    do {
+	int *lits = C_LITS(confl);
+	for (i = p < 0 ? 0 : 1; i < C_SIZE(confl); i++) {
+	    int q = lits[i], v = VAR(q);
+	    if (seen[v] || levels[v] == 0)
+		continue;
+	    seen[v] = 1;
+	    bump(v);
+	    if (levels[v] == nlevels)
+		pending++;
+	    else {
+		tmp = reserve(tmp, &tmp_cap, n, 1, sizeof(int));
+		tmp[n++] = q;
+	    }
+	}
+	while (!seen[VAR(trail[idx])])
+	    idx--;
+	p = trail[idx--];
+	confl = reasons[VAR(p)];
+	seen[VAR(p)] = 0;
+	pending--;
+    } while (pending > 0);
+    tmp[0] = p ^ 1;
+
+    max_i = 1;
+    for (i = 1; i < n; i++) {
+	seen[VAR(tmp[i])] = 0;
+	if (levels[VAR(tmp[i])] > levels[VAR(tmp[max_i])])
+	    max_i = i;
+    }
+    if (n == 1)
+	*bt_level = 0;
+    else {
+	int t = tmp[1];
+	tmp[1] = tmp[max_i];
+	tmp[max_i] = t;
+	*bt_level = levels[VAR(tmp[1])];
+    }
+    return n;
+}
+
+/* Number of distinct decision levels in clause */
+static int clause_lbd(int lits[], int n) {
+    int count = 0, i, j;
+    for (i = 0; i < n; i++) {
+	for (j = 0; j < i; j++)
+	    if (levels[VAR(lits[j])] == levels[VAR(lits[i])])
+		break;
+	if (j == i)
+	    count++;
+    }
+    return count;
+}
+
+static int lbd_cmp(const void *a, const void *b) {
+    return *(const int *) a - *(const int *) b;
+}
+
+/*
+ * Remove half of the learned clauses with high LBD, along with
+ * clauses satisfied at level 0 and false literals.  Called at level 0,
+ * where no clause is a reason for an assignment that matters
+ */
+static void reduce() {
+    int *lbds = sat_alloc(NULL, (nlearnts + 1) * sizeof(int));
+    int n = 0, cutoff, remove, c, i, old_n = arena_n;
+    int *old = arena;
+
+    for (c = 0; c < old_n; c += old[c] + 2)
+	if (old[c+1] > GLUE_LBD)
+	    lbds[n++] = old[c+1];
+    qsort(lbds, n, sizeof(int), lbd_cmp);
+    cutoff = n ? lbds[n/2] : 0;
+    remove = n / 2;
+    free(lbds);
+
+    for (i = 0; i < nvars; i++)
+	reasons[i] = -1;
+    for (i = 0; i < 2 * nvars; i++)
+	watches[i].n = 0;
+    arena = NULL;
+    arena_n = arena_cap = 0;
+    nclauses = nlearnts = 0;
+    for (c = 0; c < old_n; c += old[c] + 2) {
+	int lbd = old[c+1];
+	if (lbd > GLUE_LBD && lbd >= cutoff && remove > 0) {
+	    remove--;
+	    continue;
+	}
+	add_clause(&old[c+2], old[c], lbd);
+    }
+    free(old);
+}
+
+/* Element i of the Luby sequence 1 1 2 1 1 2 4 1 1 2 ... */
+static int luby(int i) {
+    int size = 1, seq = 0;
+    while (size < i + 1) {
+	seq++;
+	size = 2 * size + 1;
+    }
+    while (size - 1 != i) {
+	size = (size - 1) / 2;
+	seq--;
+	i = i % size;
+    }
+    return 1 << seq;
+}
+
+int sat_solve(long long max_conflicts) {
+    long long conflicts = 0;
+    int restarts = 0, restart_left = RESTART_BASE;
+
+    if (unsat || propagate() >= 0)
+	return SAT_UNSAT;
+    for (;;) {
+	int confl = propagate();
+	if (confl >= 0) {
+	    int bt_level, n;
+	    conflicts++;
+	    if (nlevels == 0)
+		return SAT_UNSAT;
+	    n = analyze(confl, &bt_level);
+	    backtrack(bt_level);
+	    if (n == 1)
+		enqueue(tmp[0], -1);
+	    else {
+		int lbd = clause_lbd(tmp, n);
+		arena = reserve(arena, &arena_cap, arena_n, n + 2, sizeof(int));
+		confl = arena_n;
+		arena_n += n + 2;
+		C_SIZE(confl) = n;
+		C_LBD(confl) = lbd > 0 ? lbd : 1;
+		memcpy(C_LITS(confl), tmp, n * sizeof(int));
+		watch(tmp[0], confl);
+		watch(tmp[1], confl);
+		nlearnts++;
+		enqueue(tmp[0], confl);
+	    }
+	    var_inc /= ACTIVITY_DECAY;
+	    if (conflicts >= max_conflicts) {
+		backtrack(0);
+		return SAT_UNKNOWN;
+	    }
+	    if (--restart_left == 0) {
+		backtrack(0);
+		restart_left = RESTART_BASE * luby(++restarts);
+		if (propagate() >= 0)
+		    return SAT_UNSAT;
+		if (nlearnts > max_learnts) {
+		    reduce();
+		    max_learnts += max_learnts / 10;
+		    if (unsat)
+			return SAT_UNSAT;
+		}
+	    }
+	} else {
+	    int v = -1;
+	    while (heap_n > 0) {
+		v = heap_pop();
+		if (values[v] == V_UNDEF)
+		    break;
+		v = -1;
+	    }
+	    if (v < 0)
+		return SAT_SAT;
+	    trail_lim[nlevels++] = trail_n;
+	    enqueue(2 * v + (phases[v] == V_FALSE), -1);
+	}
+    }
+}
+
+/**************************
+ * Gates
+ **************************/
+
+#define G_AND 1
+#define G_XOR 2
+#define G_ITE 3
+
+static unsigned gate_hash(int op, int a, int b, int c) {
+    unsigned h = op * 2654435761u ^ a * 12582917u ^ b * 4256249u ^ c * 741457u;
+    return h ^ (h >> 15);
+}
+
+/* Find existing gate, or create variable for a new one.  Set *is_new
+   when the caller must add its clauses */
+static int find_gate(int op, int a, int b, int c, int *is_new) {
+    unsigned h;
+    int i;
+
+    if (2 * (ngates + 1) > gate_size) {
+	gate_t *old = gates;
+	int old_size = gate_size;
+	gate_size = gate_size ? 2 * gate_size : 1 << 12;
+	gates = sat_alloc(NULL, gate_size * sizeof(gate_t));
+	for (i = 0; i < gate_size; i++)
+	    gates[i].op = 0;
+	for (i = 0; i < old_size; i++)
+	    if (old[i].op) {
+		h = gate_hash(old[i].op, old[i].a, old[i].b, old[i].c) & (gate_size-1);
+		while (gates[h].op)
+		    h = (h + 1) & (gate_size-1);
+		gates[h] = old[i];
+	    }
+	free(old);
+    }
+    h = gate_hash(op, a, b, c) & (gate_size-1);
+    while (gates[h].op) {
+	if (gates[h].op == op && gates[h].a == a && gates[h].b == b
+	    && gates[h].c == c) {
+	    *is_new = 0;
+	    return gates[h].result;
+	}
+	h = (h + 1) & (gate_size-1);
+    }
+    gates[h].op = op;
+    gates[h].a = a;
+    gates[h].b = b;
+    gates[h].c = c;
+    gates[h].result = sat_new_var();
+    ngates++;
+    *is_new = 1;
+    return gates[h].result;
+}
+
+int sat_not(int a) {
+    return a ^ 1;
+}
+
+int sat_and(int a, int b) {
+    int g, is_new;
+    if (a == SAT_FALSE || b == SAT_FALSE || a == (b ^ 1))
+	return SAT_FALSE;
+    if (a == SAT_TRUE || a == b)
+	return b;
+    if (b == SAT_TRUE)
+	return a;
+    if (a > b) {
+	int t = a;
+	a = b;
+	b = t;
+    }
+    g = find_gate(G_AND, a, b, 0, &is_new);
+    if (is_new) {
+	clause(2, g ^ 1, a, 0);
+	clause(2, g ^ 1, b, 0);
+	clause(3, g, a ^ 1, b ^ 1);
+    }
+    return g;
+}
+
+int sat_or(int a, int b) {
+    return sat_and(a ^ 1, b ^ 1) ^ 1;
+}
+
+int sat_xor(int a, int b) {
+    /* Negations are moved to the output */
+    int neg = NEG(a) ^ NEG(b);
+    int g, is_new;
+    a &= ~1;
+    b &= ~1;
+    if (a == b)
+	return SAT_FALSE ^ neg;
+    if (a == SAT_TRUE)
+	return b ^ 1 ^ neg;
+    if (b == SAT_TRUE)
+	return a ^ 1 ^ neg;
+    if (a > b) {
+	int t = a;
+	a = b;
+	b = t;
+    }
+    g = find_gate(G_XOR, a, b, 0, &is_new);
+    if (is_new) {
+	clause(3, g ^ 1, a, b);
+	clause(3, g ^ 1, a ^ 1, b ^ 1);
+	clause(3, g, a ^ 1, b);
+	clause(3, g, a, b ^ 1);
+    }
+    return g ^ neg;
+}
+
+int sat_ite(int i, int t, int e) {
+    int g, is_new;
+    if (i == SAT_TRUE || t == e)
+	return t;
+    if (i == SAT_FALSE)
+	return e;
+    if (NEG(i)) {
+	int x = t;
+	t = e;
+	e = x;
+	i ^= 1;
+    }
+    if (t == SAT_TRUE || t == i)
+	return sat_or(i, e);
+    if (t == SAT_FALSE || t == (i ^ 1))
+	return sat_and(i ^ 1, e);
+    if (e == SAT_FALSE || e == i)
+	return sat_and(i, t);
+    if (e == SAT_TRUE || e == (i ^ 1))
+	return sat_or(i ^ 1, t);
+    if (t == (e ^ 1))
+	return sat_xor(i, e);
+    g = find_gate(G_ITE, i, t, e, &is_new);
+    if (is_new) {
+	clause(3, i ^ 1, t ^ 1, g);
+	clause(3, i ^ 1, t, g ^ 1);
+	clause(3, i, e ^ 1, g);
+	clause(3, i, e, g ^ 1);
+	/* Redundant, but help propagation */
+	clause(3, t ^ 1, e ^ 1, g);
+	clause(3, t, e, g ^ 1);
+    }
+    return g;
+}
@@ -0,0 +1,48 @@
+/*
+ * CS 208 Lab 1: Data Lab
+ *
+ * sat.h - Boolean satisfiability solver, with a circuit builder
+ *
+ * Literals are integers 2*v for variable v and 2*v+1 for its
+ * negation.  Gate functions build new literals for logic over
+ * existing ones, adding the clauses that define them (the Tseitin
+ * encoding).  Gates are simplified when an input is constant, and
+ * identical gates are shared.
+ */
+
+#define SAT_TRUE  0
+#define SAT_FALSE 1
+
+/* Results of sat_solve */
+#define SAT_UNSAT   0
+#define SAT_SAT     1
+#define SAT_UNKNOWN (-1)
+
+/* Start over with no variables or clauses */
+void sat_reset();
+
+/* Literal for a new, unconstrained variable */
+int sat_new_var();
+
+int sat_not(int a);
+int sat_and(int a, int b);
+int sat_or(int a, int b);
+int sat_xor(int a, int b);
+/* If-then-else: (i & t) | (~i & e) */
+int sat_ite(int i, int t, int e);
+
+/* Require literal a to be true */
+void sat_assert(int a);
+
+/*
+ * Find an assignment satisfying all the requirements, giving up after
+ * max_conflicts conflicts.  Return SAT_SAT, SAT_UNSAT, or SAT_UNKNOWN
+ */
+int sat_solve(long long max_conflicts);
+
+/* Value of literal in the assignment found by sat_solve */
+int sat_value(int a);
+
+/* Size of problem */
+int sat_var_count();
+int sat_clause_count();
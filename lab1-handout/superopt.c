@@ -0,0 +1,655 @@
+/*
+ * CS 208 Lab 1: Data Lab
+ *
+ * superopt.c - Search for puzzle solutions with the fewest operators.
+ *
+ * For each puzzle, expressions over the arguments and a few constants
+ * are enumerated in order of their number of operators, using only
+ * the operators the puzzle allows.  Each expression is
+ * represented by its values on a set of sample arguments, and only the
+ * first expression found with a given set of values is kept, since
+ * anything built from a later one could be built from it just as
+ * cheaply.  An expression whose values all match the reference
+ * function is then proved correct with BDDs.  If the proof fails, the
+ * counterexample replaces one of the samples and the search starts
+ * over.
+ *
+ * Expressions are trees, so a subexpression used twice is counted
+ * twice, where a solution could store it in a variable and dlc would
+ * count it once.  The counts found are therefore upper bounds when a
+ * solution can share work.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include "btest.h"
+#include "bdd.h"
+#include "bvexpr.h"
+
+/* Constants used directly are 0..MAX_SMALL and the byte mask.  Others
+   must be built with operators, which keeps the number of expressions
+   from growing too fast */
+#define MAX_SMALL 32
+#define BYTE_MASK 0xff
+
+/* Sample arguments on which expressions are evaluated */
+#define NSAMPLES 32
+
+/* Most expressions kept for one puzzle.  Each takes NSAMPLES ints */
+#define MAX_EXPRS (1 << 20)
+
+/* Chains in hash table of expression values */
+#define NBUCKETS (1 << 20)
+
+/* Locks on the hash table, each covering every NLOCKS'th chain */
+#define NLOCKS 256
+
+/* Left operands per task when building expressions in parallel */
+#define CHUNK 64
+
+/* Default search time per puzzle, in seconds */
+#define BUDGET 10
+
+/* Most BDD nodes used to verify a candidate */
+#define NODE_LIMIT 4000000
+
+#define MAX_ARGS 3
+
+/* Largest operator count searched */
+#define MAX_COST 64
+
+/* Arguments with fewer than this many possible values come first in
+   the BDD variable ordering, as in bddcheck */
+#define SMALL_RANGE 256
+
+/* Defined in decl.c */
+extern test_rec test_set[];
+
+/* Expression operators */
+#define OP_VAR   0          /* Argument number left */
+#define OP_CONST 1          /* Constant left */
+#define OP_NOT   2
+#define OP_INV   3
+#define OP_AND   4
+#define OP_XOR   5
+#define OP_OR    6
+#define OP_ADD   7
+#define OP_SHL   8
+#define OP_SHR   9
+#define NOPS     10
+
+static char *op_names[NOPS] = {"", "", "!", "~", "&", "^", "|", "+", "<<", ">>"};
+
+#define IS_UNARY(op) ((op) == OP_NOT || (op) == OP_INV)
+#define IS_COMMUTATIVE(op) ((op) >= OP_AND && (op) <= OP_ADD)
+
+typedef struct {
+    int op;
+    int left, right;
+    int args;               /* Bit mask of arguments used */
+    int next;               /* Next expression in hash chain */
+} expr_t;
+
+static expr_t *exprs;
+static int *values;         /* NSAMPLES values of each expression */
+static int nexprs;
+static int *buckets;
+static pthread_mutex_t locks[NLOCKS];
+
+/* Expressions with each operator count */
+static int level_start[MAX_COST+1], level_end[MAX_COST+1];
+
+/* Puzzle being searched */
+static test_ptr cur;
+static int allowed[NOPS];
+static int samples[MAX_ARGS][NSAMPLES];
+static int target[NSAMPLES];
+
+/* Search state shared by the threads */
+static expr_t found;
+static int have_found;
+static int stop;
+static double deadline;
+static pthread_mutex_t found_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Work for one level of the search */
+typedef struct {
+    int op;
+    int left_lo, left_hi;   /* Range of left operands */
+    int right_cost;         /* Cost of right operands */
+} task_t;
+
+static task_t *tasks;
+static int ntasks, alloc_tasks, next_task;
+static int store;           /* Keep new expressions? */
+static int store_consts;    /* Keep new expressions without arguments? */
+
+/* Command line settings */
+static char *test_fname = NULL;
+static int nthreads = 0;
+static int budget = BUDGET;
+
+static bit_ops_t bdd_ops = {
+    BDD_FALSE, BDD_TRUE, bdd_not, bdd_and, bdd_or, bdd_xor, bdd_ite
+};
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1.0E-9 * ts.tv_nsec;
+}
+
+static void *alloc_or_die(size_t size) {
+    void *p = malloc(size);
+    if (!p) {
+	printf("Couldn't allocate space for expressions\n");
+	exit(1);
+    }
+    return p;
+}
+
+/**************************
+ * Evaluating expressions
+ **************************/
+
+/*
+ * Apply op to operand values a and b, storing results in out.  Return
+ * 0 if a shift amount is out of range for some sample, since the
+ * result would be undefined.  These loops are simple enough for the
+ * compiler to vectorize
+ */
+static int apply(int op, const int *a, const int *b, int *out) {
+    int k;
+
+    switch (op) {
+    case OP_NOT:
+	for (k = 0; k < NSAMPLES; k++)
+	    out[k] = !a[k];
+	break;
+    case OP_INV:
+	for (k = 0; k < NSAMPLES; k++)
+	    out[k] = ~a[k];
+	break;
+    case OP_AND:
+	for (k = 0; k < NSAMPLES; k++)
+	    out[k] = a[k] & b[k];
+	break;
+    case OP_XOR:
+	for (k = 0; k < NSAMPLES; k++)
+	    out[k] = a[k] ^ b[k];
+	break;
+    case OP_OR:
+	for (k = 0; k < NSAMPLES; k++)
+	    out[k] = a[k] | b[k];
+	break;
+    case OP_ADD:
+	for (k = 0; k < NSAMPLES; k++)
+	    out[k] = (int) ((unsigned) a[k] + (unsigned) b[k]);
+	break;
+    case OP_SHL:
+    case OP_SHR: {
+	unsigned bad = 0;
+	for (k = 0; k < NSAMPLES; k++)
+	    bad |= (unsigned) b[k] > 31;
+	if (bad)
+	    return 0;
+	if (op == OP_SHL)
+	    for (k = 0; k < NSAMPLES; k++)
+		out[k] = (int) ((unsigned) a[k] << b[k]);
+	else
+	    for (k = 0; k < NSAMPLES; k++)
+		out[k] = a[k] >> b[k];
+	break;
+    }
+    }
+    return 1;
+}
+
+static unsigned hash_values(const int *v) {
+    unsigned h = 2166136261u;
+    int k;
+    for (k = 0; k < NSAMPLES; k++)
+	h = (h ^ v[k]) * 16777619u;
+    return h ^ (h >> 16);
+}
+
+/*
+ * Consider new expression with values v.  If it matches the target,
+ * record it as the solution.  Otherwise keep it if store is set and
+ * no earlier expression has the same values
+ */
+static void add_expr(int op, int left, int right, int args, const int *v) {
+    unsigned b;
+    pthread_mutex_t *lock;
+    int i;
+
+    if (memcmp(v, target, sizeof(target)) == 0) {
+	pthread_mutex_lock(&found_lock);
+	if (!have_found) {
+	    found.op = op;
+	    found.left = left;
+	    found.right = right;
+	    have_found = 1;
+	    stop = 1;
+	}
+	pthread_mutex_unlock(&found_lock);
+	return;
+    }
+    if (!store || (!args && !store_consts))
+	return;
+    b = hash_values(v) & (NBUCKETS-1);
+    lock = &locks[b % NLOCKS];
+    pthread_mutex_lock(lock);
+    for (i = buckets[b]; i >= 0; i = exprs[i].next)
+	if (memcmp(&values[i * NSAMPLES], v, NSAMPLES * sizeof(int)) == 0)
+	    break;
+    if (i < 0) {
+	i = __atomic_fetch_add(&nexprs, 1, __ATOMIC_RELAXED);
+	if (i < MAX_EXPRS) {
+	    exprs[i].op = op;
+	    exprs[i].left = left;
+	    exprs[i].right = right;
+	    exprs[i].args = args;
+	    memcpy(&values[i * NSAMPLES], v, NSAMPLES * sizeof(int));
+	    exprs[i].next = buckets[b];
+	    buckets[b] = i;
+	}
+    }
+    pthread_mutex_unlock(lock);
+}
+
+/* Run one task of the current level */
+static void run_task(task_t *tp) {
+    int v[NSAMPLES];
+    int lo = level_start[tp->right_cost], hi = level_end[tp->right_cost];
+    int i, j;
+
+    for (i = tp->left_lo; i < tp->left_hi && !stop; i++) {
+	int *a = &values[i * NSAMPLES];
+	if (IS_UNARY(tp->op)) {
+	    apply(tp->op, a, NULL, v);
+	    add_expr(tp->op, i, -1, exprs[i].args, v);
+	    continue;
+	}
+	/* For commutative operators, each pair is only tried once */
+	for (j = IS_COMMUTATIVE(tp->op) && i >= lo && i < hi ? i : lo;
+	     j < hi; j++)
+	    if (apply(tp->op, a, &values[j * NSAMPLES], v))
+		add_expr(tp->op, i, j, exprs[i].args | exprs[j].args, v);
+    }
+}
+
+static void *run_worker(void *arg) {
+    for (;;) {
+	int i = __atomic_fetch_add(&next_task, 1, __ATOMIC_RELAXED);
+	if (i >= ntasks || stop)
+	    break;
+	run_task(&tasks[i]);
+	if (now() > deadline)
+	    stop = 1;
+    }
+    return NULL;
+}
+
+static void add_task(int op, int lo, int hi, int right_cost) {
+    int i;
+    for (i = lo; i < hi; i += CHUNK) {
+	if (ntasks == alloc_tasks) {
+	    alloc_tasks = alloc_tasks ? 2 * alloc_tasks : 1024;
+	    tasks = realloc(tasks, alloc_tasks * sizeof(task_t));
+	    if (!tasks) {
+		printf("Couldn't allocate space for tasks\n");
+		exit(1);
+	    }
+	}
+	tasks[ntasks].op = op;
+	tasks[ntasks].left_lo = i;
+	tasks[ntasks].left_hi = i + CHUNK < hi ? i + CHUNK : hi;
+	tasks[ntasks].right_cost = right_cost;
+	ntasks++;
+    }
+}
+
+/* Build the expressions with cost operators, from smaller ones */
+static void build_level(int cost, int max_cost) {
+    pthread_t *tids = alloc_or_die(nthreads * sizeof(pthread_t));
+    int op, lc, i;
+
+    ntasks = next_task = 0;
+    for (op = OP_NOT; op < NOPS; op++) {
+	if (!allowed[op])
+	    continue;
+	if (IS_UNARY(op))
+	    add_task(op, level_start[cost-1], level_end[cost-1], 0);
+	else
+	    for (lc = 0; lc < cost; lc++)
+		if (!IS_COMMUTATIVE(op) || lc <= cost - 1 - lc)
+		    add_task(op, level_start[lc], level_end[lc], cost - 1 - lc);
+    }
+    /* The last level is only checked against the target.  Constants
+       needing more than one operator are rarely worth their cost, and
+       there are so many that they would crowd out everything else */
+    store = cost < max_cost;
+    store_consts = cost == 1;
+    for (i = 0; i < nthreads; i++)
+	if (pthread_create(&tids[i], NULL, run_worker, NULL) != 0) {
+	    printf("Couldn't create worker thread\n");
+	    exit(1);
+	}
+    for (i = 0; i < nthreads; i++)
+	pthread_join(tids[i], NULL);
+    free(tids);
+}
+
+/**************************
+ * Checking candidates
+ **************************/
+
+/* Append text of expression e to buf */
+static void print_expr(char *buf, size_t size, expr_t *e) {
+    static char *arg_names[MAX_ARGS] = {"x", "y", "z"};
+    size_t len = strlen(buf);
+
+    switch (e->op) {
+    case OP_VAR:
+	snprintf(buf + len, size - len, "%s", arg_names[e->left]);
+	break;
+    case OP_CONST:
+	snprintf(buf + len, size - len, e->left > 9 ? "0x%x" : "%d", e->left);
+	break;
+    case OP_NOT:
+    case OP_INV:
+	snprintf(buf + len, size - len, "%s", op_names[e->op]);
+	print_expr(buf, size, &exprs[e->left]);
+	break;
+    default:
+	snprintf(buf + len, size - len, "(");
+	print_expr(buf, size, &exprs[e->left]);
+	len = strlen(buf);
+	snprintf(buf + len, size - len, " %s ", op_names[e->op]);
+	print_expr(buf, size, &exprs[e->right]);
+	len = strlen(buf);
+	snprintf(buf + len, size - len, ")");
+	break;
+    }
+}
+
+/*
+ * Prove that expression text equals the reference function, using
+ * BDDs as bddcheck does.  Return 1 if it does, 0 if not, storing a
+ * counterexample in cex, and -1 if the proof could not be completed
+ */
+static int verify(char *text, int cex[]) {
+    static char src[8192];
+    char tname[256], vals[MAX_ARGS * BV_MAX_WIDTH];
+    func_ptr f, ft;
+    bv_t args[MAX_ARGS], r, rt;
+    int small[MAX_ARGS];
+    int nvars = 0, diff = BDD_FALSE, ok = BDD_TRUE;
+    int i, b;
+
+    snprintf(src, sizeof(src), "int superopt_candidate(%s) { return %s; }",
+	     cur->args == 1 ? "int x" : cur->args == 2 ? "int x, int y"
+	     : "int x, int y, int z", text);
+    bv_parse_text(src, "candidate");
+    snprintf(tname, sizeof(tname), "test_%s", cur->name);
+    f = bv_find_func("superopt_candidate");
+    ft = bv_find_func(tname);
+    if (!f || !ft || bv_func_error(f) || bv_func_error(ft))
+	return -1;
+
+    bdd_reset(NODE_LIMIT);
+    for (i = 0; i < cur->args; i++) {
+	args[i].type = bv_func_param_type(ft, i);
+	small[i] = (long long) cur->arg_ranges[i][1] - cur->arg_ranges[i][0]
+	    < SMALL_RANGE;
+    }
+    for (i = 0; i < cur->args; i++)
+	if (small[i])
+	    for (b = 31; b >= 0; b--)
+		args[i].bits[b] = bdd_var(nvars++);
+    for (b = 31; b >= 0; b--)
+	for (i = 0; i < cur->args; i++)
+	    if (!small[i])
+		args[i].bits[b] = bdd_var(nvars++);
+    if (bv_eval_func(f, args, &bdd_ops, &r)
+	|| bv_eval_func(ft, args, &bdd_ops, &rt))
+	return -1;
+    for (b = 0; b < 32; b++)
+	diff = bdd_or(diff, bdd_xor(r.bits[b], rt.bits[b]));
+    for (i = 0; i < cur->args; i++) {
+	bv_t lo, hi;
+	bv_const(&bdd_ops, args[i].type, cur->arg_ranges[i][0], &lo);
+	bv_const(&bdd_ops, args[i].type, cur->arg_ranges[i][1], &hi);
+	ok = bdd_and(ok, bdd_not(bv_less(&bdd_ops, &args[i], &lo)));
+	ok = bdd_and(ok, bdd_not(bv_less(&bdd_ops, &hi, &args[i])));
+    }
+    diff = bdd_and(diff, ok);
+    if (bdd_overflow)
+	return -1;
+    if (diff == BDD_FALSE)
+	return 1;
+    bdd_satisfy(diff, vals, nvars);
+    for (i = 0; i < cur->args; i++) {
+	unsigned u = 0;
+	for (b = 0; b < 32; b++)
+	    if (bdd_eval(args[i].bits[b], vals))
+		u |= 1u << b;
+	cex[i] = (int) u;
+    }
+    return 0;
+}
+
+/**************************
+ * Search
+ **************************/
+
+static int call_ref(int a[]) {
+    switch (cur->args) {
+    case 1:
+	return ((funct1_t) cur->test_funct)(a[0]);
+    case 2:
+	return ((funct2_t) cur->test_funct)(a[0], a[1]);
+    default:
+	return ((funct3_t) cur->test_funct)(a[0], a[1], a[2]);
+    }
+}
+
+static void set_sample(int k, int a[]) {
+    int i;
+    for (i = 0; i < cur->args; i++)
+	samples[i][k] = a[i];
+    target[k] = call_ref(a);
+}
+
+/*
+ * Initial samples: the ends of each argument's range, values near
+ * zero, and random values
+ */
+static void init_samples() {
+    unsigned seed = 1;
+    int a[MAX_ARGS] = {0, 0, 0};
+    int k, i;
+
+    for (k = 0; k < NSAMPLES; k++) {
+	for (i = 0; i < cur->args; i++) {
+	    int min = cur->arg_ranges[i][0], max = cur->arg_ranges[i][1];
+	    int special[5];
+	    special[0] = min;
+	    special[1] = max;
+	    special[2] = 0;
+	    special[3] = 1;
+	    special[4] = -1;
+	    if (k < 5 && special[(k + i) % 5] >= min && special[(k + i) % 5] <= max)
+		a[i] = special[(k + i) % 5];
+	    else {
+		long long span = (long long) max - min + 1;
+		unsigned r = (unsigned) rand_r(&seed) << 16 ^ (unsigned) rand_r(&seed);
+		a[i] = (int) (min + (long long) (r % span));
+	    }
+	}
+	set_sample(k, a);
+    }
+}
+
+static void add_terminal(int op, int val) {
+    int v[NSAMPLES];
+    int k;
+    for (k = 0; k < NSAMPLES; k++)
+	v[k] = op == OP_VAR ? samples[val][k] : val;
+    add_expr(op, val, -1, op == OP_VAR ? 1 << val : 0, v);
+}
+
+/*
+ * Search for expressions with at most max_cost operators matching the
+ * samples.  Return cost of the one found, or -1 if none.  Set *done to
+ * the largest cost for which the search was complete
+ */
+static int search(int max_cost, int *done) {
+    int cost, i, full = 0;
+
+    nexprs = 0;
+    have_found = 0;
+    for (i = 0; i < NBUCKETS; i++)
+	buckets[i] = -1;
+    *done = -1;
+
+    store = store_consts = 1;
+    level_start[0] = 0;
+    for (i = 0; i < cur->args; i++)
+	add_terminal(OP_VAR, i);
+    for (i = 0; i <= MAX_SMALL; i++)
+	add_terminal(OP_CONST, i);
+    add_terminal(OP_CONST, BYTE_MASK);
+    level_end[0] = nexprs;
+    if (have_found)
+	return 0;
+    *done = 0;
+
+    for (cost = 1; cost <= max_cost && !stop; cost++) {
+	level_start[cost] = nexprs;
+	/* Once the table has filled up, one more level can still be
+	   checked against the target, without keeping anything */
+	build_level(cost, full ? cost : max_cost);
+	if (have_found)
+	    return cost;
+	if (full)
+	    break;
+	if (nexprs > MAX_EXPRS) {
+	    nexprs = MAX_EXPRS;
+	    full = 1;
+	} else if (!stop)
+	    *done = cost;
+	level_end[cost] = nexprs;
+    }
+    return -1;
+}
+
+/* Parse the list of allowed operators */
+static int get_allowed(char *ops) {
+    char buf[256];
+    char *tok;
+    int op;
+
+    memset(allowed, 0, sizeof(allowed));
+    if (strchr(ops, '$'))
+	return 0;
+    strncpy(buf, ops, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    for (tok = strtok(buf, " "); tok; tok = strtok(NULL, " "))
+	for (op = OP_NOT; op < NOPS; op++)
+	    if (strcmp(tok, op_names[op]) == 0)
+		allowed[op] = 1;
+    return 1;
+}
+
+static void superopt(test_ptr t) {
+    int max_cost = t->op_limit < MAX_COST ? t->op_limit : MAX_COST;
+    char text[4096];
+    int cost, done, result, cex[MAX_ARGS];
+
+    cur = t;
+    /* The search works on 32-bit values */
+    if (t->args < 1 || t->args > MAX_ARGS || (t->width && t->width != 32)
+	|| !get_allowed(t->ops)) {
+	printf("-\t%d\t%s\t(not searched)\n", t->op_limit, t->name);
+	return;
+    }
+    init_samples();
+    deadline = now() + budget;
+    stop = 0;
+    for (;;) {
+	cost = search(max_cost, &done);
+	if (cost < 0) {
+	    if (done == max_cost)
+		printf("-\t%d\t%s\t(none within limit)\n", t->op_limit, t->name);
+	    else
+		printf("-\t%d\t%s\t(none with at most %d operators)\n",
+		       t->op_limit, t->name, done);
+	    return;
+	}
+	text[0] = '\0';
+	print_expr(text, sizeof(text), &found);
+	result = verify(text, cex);
+	if (result != 0)
+	    break;
+	/* Learn from counterexample, replacing a random sample */
+	set_sample(NSAMPLES / 2 + rand() % (NSAMPLES / 2), cex);
+	stop = now() > deadline;
+    }
+    printf("%d\t%d\t%s\t%s%s\n", cost, t->op_limit, t->name, text,
+	   result < 0 ? "  (not verified)" : "");
+}
+
+static void usage(char *cmd) {
+    printf("Usage: %s [-h] [-f <name>] [-j <n>] [-t <secs>]\n", cmd);
+    printf("  -f <name> Search only for the named function\n");
+    printf("  -h        Print this message\n");
+    printf("  -j <n>    Search with n threads (default: one per processor)\n");
+    printf("  -t <secs> Search each function for at most secs seconds (default %d)\n", BUDGET);
+    exit(1);
+}
+
+int main(int argc, char *argv[]) {
+    int c, i;
+
+    while ((c = getopt(argc, argv, "hf:j:t:")) != -1)
+	switch (c) {
+	case 'f':
+	    test_fname = optarg;
+	    break;
+	case 'j':
+	    nthreads = atoi(optarg);
+	    if (nthreads < 1)
+		usage(argv[0]);
+	    break;
+	case 't':
+	    budget = atoi(optarg);
+	    if (budget < 1)
+		usage(argv[0]);
+	    break;
+	default:
+	    usage(argv[0]);
+	}
+    if (nthreads == 0)
+	nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (!bv_parse_file("tests.c")) {
+	printf("Couldn't read tests.c\n");
+	exit(1);
+    }
+
+    exprs = alloc_or_die(MAX_EXPRS * sizeof(expr_t));
+    values = alloc_or_die((size_t) MAX_EXPRS * NSAMPLES * sizeof(int));
+    buckets = alloc_or_die(NBUCKETS * sizeof(int));
+    for (i = 0; i < NLOCKS; i++)
+	pthread_mutex_init(&locks[i], NULL);
+
+    printf("Ops\tLimit\tFunction\tSolution\n");
+    for (i = 0; test_set[i].solution_funct; i++)
+	if (!test_fname || strcmp(test_set[i].name, test_fname) == 0)
+	    superopt(&test_set[i]);
+    return 0;
+}
@@ -108,10 +108,35 @@ int test_absVal(int x) {
   return (x < 0) ? -x : x;
 }
 int test_isPower2(int x) {
-  int i;
-  for (i = 0; i < 31; i++) {
-    if (x == 1<<i)
-      return 1;
-  }
-  return 0;
+  /* Same as checking x == 1<<i for i = 0..30, but without a loop, so
+     that batch kernels can vectorize it */
+  return x > 0 && (x & (x - 1)) == 0;
+}
+unsigned test_floatNegate(unsigned uf) {
+    float f = u2f(uf);
+    float nf = -f;
+    if (isnan(f))
+      return uf;
+    else
+      return f2u(nf);
+}
+unsigned test_floatScale2(unsigned uf) {
+  float f = u2f(uf);
+  float tf = 2*f;
+  if (isnan(f))
+    return uf;
+  else
+    return f2u(tf);
+}
+unsigned test_floatInt2Float(int x) {
+  float f = (float) x;
+  return f2u(f);
+}
+int test_floatFloat2Int(unsigned uf) {
+  float f = u2f(uf);
+  /* Spelled out, since converting an out of range value is undefined,
+     and vectorized code may not give 0x80000000u */
+  if (!(f > -2147483904.0f && f < 2147483648.0f))
+    return 0x80000000u;
+  return (int) f;
 }